@@ -0,0 +1,328 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * genbench.cpp
+ * Generates synthetic networks (model/graph/config) for benchmarking
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+/**************************************************************************
+* Benchmark parameters
+**************************************************************************/
+
+// Parameters of a synthetic network
+//
+struct bench_t {
+  std::string outdir;   // directory to write files to
+  std::string name;     // file base of the network
+  long long order;      // total number of vertices
+  int npop;             // number of vertex populations
+  double cutoff;        // connection cutoff radius
+  double density;       // vertices per unit area (or volume)
+  std::string shape;    // circle or sphere
+  std::string mix;      // uniform:sigmoid:index rule weights
+  double prob;          // connection probability (uniform/max sigmoid)
+  int netfiles;         // number of data files
+  long long netparts;   // number of partitions
+  unsigned int seed;    // random seed
+};
+
+// Usage
+//
+void Usage(const char *prog) {
+  printf("Usage: %s [options]\n"
+      "  --outdir   dir    output directory (default: .)\n"
+      "  --name     str    network file base (default: benchnet)\n"
+      "  --order    n      total number of vertices (default: 1000)\n"
+      "  --npop     n      number of vertex populations (default: 2)\n"
+      "  --cutoff   r      connection cutoff radius (default: 50.0)\n"
+      "  --density  d      vertices per unit area/volume (default: 0.01)\n"
+      "  --shape    str    circle or sphere (default: circle)\n"
+      "  --mix      u:s:i  weights of uniform:sigmoid:index rules (default: 1:1:0)\n"
+      "  --prob     p      connection probability (default: 0.1)\n"
+      "  --netfiles n      number of data files (default: 1)\n"
+      "  --netparts n      number of partitions (default: netfiles)\n"
+      "  --seed     n      random seed (default: 2032)\n", prog);
+}
+
+// Parse arguments
+//
+int ParseArgs(int argc, char **argv, bench_t &bench) {
+  // Defaults
+  bench.outdir = std::string(".");
+  bench.name = std::string("benchnet");
+  bench.order = 1000;
+  bench.npop = 2;
+  bench.cutoff = 50.0;
+  bench.density = 0.01;
+  bench.shape = std::string("circle");
+  bench.mix = std::string("1:1:0");
+  bench.prob = 0.1;
+  bench.netfiles = 1;
+  bench.netparts = 0;
+  bench.seed = 2032;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+      Usage(argv[0]);
+      exit(0);
+    }
+    if (i+1 >= argc) {
+      printf("Error: missing value for %s\n", argv[i]);
+      return 1;
+    }
+    const char *arg = argv[i];
+    const char *val = argv[++i];
+    if (!strcmp(arg, "--outdir")) { bench.outdir = std::string(val); }
+    else if (!strcmp(arg, "--name")) { bench.name = std::string(val); }
+    else if (!strcmp(arg, "--order")) { bench.order = (long long) atof(val); }
+    else if (!strcmp(arg, "--npop")) { bench.npop = atoi(val); }
+    else if (!strcmp(arg, "--cutoff")) { bench.cutoff = atof(val); }
+    else if (!strcmp(arg, "--density")) { bench.density = atof(val); }
+    else if (!strcmp(arg, "--shape")) { bench.shape = std::string(val); }
+    else if (!strcmp(arg, "--mix")) { bench.mix = std::string(val); }
+    else if (!strcmp(arg, "--prob")) { bench.prob = atof(val); }
+    else if (!strcmp(arg, "--netfiles")) { bench.netfiles = atoi(val); }
+    else if (!strcmp(arg, "--netparts")) { bench.netparts = atoll(val); }
+    else if (!strcmp(arg, "--seed")) { bench.seed = (unsigned int) atol(val); }
+    else {
+      printf("Error: unknown option %s\n", arg);
+      return 1;
+    }
+  }
+
+  // Sanity checks
+  if (bench.order < bench.npop || bench.npop < 1) {
+    printf("Error: order must be at least npop (>= 1)\n");
+    return 1;
+  }
+  if (bench.shape != "circle" && bench.shape != "sphere") {
+    printf("Error: shape must be circle or sphere\n");
+    return 1;
+  }
+  if (bench.netfiles < 1) {
+    printf("Error: netfiles must be positive\n");
+    return 1;
+  }
+  if (bench.netparts == 0) {
+    bench.netparts = bench.netfiles;
+  }
+
+  return 0;
+}
+
+
+/**************************************************************************
+* Writing network files
+**************************************************************************/
+
+// Write models
+//
+int WriteModel(const bench_t &bench) {
+  FILE *pModel;
+  std::string filename = bench.outdir + "/" + bench.name + ".model";
+  pModel = fopen(filename.c_str(), "w");
+  if (pModel == NULL) {
+    printf("Error opening %s for writing\n", filename.c_str());
+    return 1;
+  }
+
+  // Vertex populations
+  for (int p = 0; p < bench.npop; ++p) {
+    fprintf(pModel, "---\n"
+        "type: vertex\n"
+        "modname: pop%d\n"
+        "modtype: 1\n"
+        "param:\n"
+        "  - name: a\n"
+        "    value: 0.02\n"
+        "state:\n"
+        "  - name: v\n"
+        "    type: constant\n"
+        "    value: -65.0\n"
+        "  - name: u\n"
+        "    type: uniform\n"
+        "    min: -14.0\n"
+        "    max: -12.0\n"
+        "...\n\n", p);
+  }
+
+  // Single edge model exercising distance-dependent state
+  fprintf(pModel, "---\n"
+      "type: edge\n"
+      "modname: syn\n"
+      "modtype: 2\n"
+      "param:\n"
+      "  - name: tau\n"
+      "    value: 20.0\n"
+      "state:\n"
+      "  - name: delay\n"
+      "    type: bounded linear\n"
+      "    rep: tick\n"
+      "    scale: 0.05\n"
+      "    offset: 1.0\n"
+      "    min: 1.0\n"
+      "    max: 20.0\n"
+      "  - name: weight\n"
+      "    type: normal\n"
+      "    mean: 1.0\n"
+      "    std: 0.1\n"
+      "...\n");
+
+  fclose(pModel);
+  return 0;
+}
+
+// Write graph
+//
+int WriteGraph(const bench_t &bench) {
+  FILE *pGraph;
+  std::string filename = bench.outdir + "/" + bench.name + ".graph";
+  pGraph = fopen(filename.c_str(), "w");
+  if (pGraph == NULL) {
+    printf("Error opening %s for writing\n", filename.c_str());
+    return 1;
+  }
+
+  // Rule weights (uniform:sigmoid:index)
+  double mixw[3] = {1.0, 1.0, 0.0};
+  if (sscanf(bench.mix.c_str(), "%lf:%lf:%lf", &mixw[0], &mixw[1], &mixw[2]) != 3 ||
+      mixw[0] < 0.0 || mixw[1] < 0.0 || mixw[2] < 0.0 || mixw[0] + mixw[1] + mixw[2] <= 0.0) {
+    printf("Error: mix must be of the form u:s:i with nonnegative weights\n");
+    fclose(pGraph);
+    return 1;
+  }
+  // Index rules pair up populations of matching order
+  if (mixw[2] > 0.0 && bench.order%bench.npop) {
+    printf("Warning: index rules between populations of unequal order\n");
+  }
+
+  // Size the region so density stays fixed as the order grows
+  // (the expected number of neighbors within cutoff is constant)
+  double radius;
+  if (bench.shape == "circle") {
+    radius = sqrt(bench.order/(M_PI*bench.density));
+  }
+  else {
+    radius = cbrt(3.0*bench.order/(4.0*M_PI*bench.density));
+  }
+
+  // Vertices (populations share the region)
+  fprintf(pGraph, "vertex:\n");
+  for (int p = 0; p < bench.npop; ++p) {
+    long long order = bench.order/bench.npop + (p < bench.order%bench.npop);
+    fprintf(pGraph, "  - modname: pop%d\n"
+        "    order: %lld\n"
+        "    shape: %s\n"
+        "    radius: %.6f\n"
+        "    coord: [0.0, 0.0, 0.0]\n", p, order, bench.shape.c_str(), radius);
+  }
+
+  // Edges, rule types are dealt out by weight over population pairs
+  fprintf(pGraph, "\nedge:\n");
+  double mixsum = mixw[0] + mixw[1] + mixw[2];
+  double mixacc[3] = {0.0, 0.0, 0.0};
+  for (int s = 0; s < bench.npop; ++s) {
+    for (int t = 0; t < bench.npop; ++t) {
+      // Pick the rule type furthest behind its share
+      int type = 0;
+      double deficit = -1.0e300;
+      for (int k = 0; k < 3; ++k) {
+        mixacc[k] += mixw[k]/mixsum;
+        if (mixw[k] > 0.0 && mixacc[k] > deficit) {
+          deficit = mixacc[k];
+          type = k;
+        }
+      }
+      mixacc[type] -= 1.0;
+
+      fprintf(pGraph, "  - source: pop%d\n"
+          "    target: [pop%d]\n"
+          "    modname: syn\n"
+          "    cutoff: %.6f\n"
+          "    connect:\n", s, t, bench.cutoff);
+      if (type == 0) {
+        fprintf(pGraph, "      - type: uniform\n"
+            "        prob: %.6f\n", bench.prob);
+      }
+      else if (type == 1) {
+        fprintf(pGraph, "      - type: sigmoid\n"
+            "        maxprob: %.6f\n"
+            "        midpoint: %.6f\n"
+            "        slope: %.6f\n", bench.prob, 0.5*bench.cutoff, 10.0/bench.cutoff);
+      }
+      else {
+        fprintf(pGraph, "      - type: index\n"
+            "        srcmul: 1\n"
+            "        srcoff: %d\n", (s == t ? 1 : 0));
+      }
+    }
+  }
+
+  fclose(pGraph);
+  return 0;
+}
+
+// Write config
+//
+int WriteConfig(const bench_t &bench) {
+  FILE *pConfig;
+  std::string filename = bench.outdir + "/" + bench.name + ".yml";
+  pConfig = fopen(filename.c_str(), "w");
+  if (pConfig == NULL) {
+    printf("Error opening %s for writing\n", filename.c_str());
+    return 1;
+  }
+
+  fprintf(pConfig, "# generated by genbench\n"
+      "# order: %lld, npop: %d, cutoff: %g, density: %g, shape: %s, mix: %s, prob: %g\n"
+      "randseed: %u\n"
+      "netwkdir: \"%s\"\n"
+      "netparts: %lld\n"
+      "netfiles: %d\n"
+      "filebase: \"%s\"\n"
+      "filesave: \".o\"\n",
+      bench.order, bench.npop, bench.cutoff, bench.density, bench.shape.c_str(), bench.mix.c_str(), bench.prob,
+      bench.seed, bench.outdir.c_str(), bench.netparts, bench.netfiles, bench.name.c_str());
+
+  fclose(pConfig);
+  return 0;
+}
+
+
+/**************************************************************************
+* Main entry point
+**************************************************************************/
+
+// Main
+//
+int main(int argc, char **argv) {
+  bench_t bench;
+
+  if (ParseArgs(argc, argv, bench)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if (WriteModel(bench) || WriteGraph(bench) || WriteConfig(bench)) {
+    return 1;
+  }
+
+  printf("Generated %s/%s (order %lld, %d populations, %d files, %lld parts)\n",
+      bench.outdir.c_str(), bench.name.c_str(), bench.order, bench.npop, bench.netfiles, bench.netparts);
+
+  return 0;
+}
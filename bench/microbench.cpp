@@ -0,0 +1,513 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * microbench.cpp
+ * Micro-benchmarks of the network generation kernels (GeNetCore)
+ * on fixed seeds and inputs, with golden checksums for correctness
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "netcore.h"
+
+
+/**************************************************************************
+* Benchmark bookkeeping
+**************************************************************************/
+
+// Build configuration (golden checksums depend on it)
+#ifdef GENET_SINGLE
+#define BENCH_PREC "single"
+#else
+#define BENCH_PREC "double"
+#endif
+#ifdef GENET_LIDX32
+#define BENCH_LIDX "lidx32"
+#else
+#define BENCH_LIDX "lidx64"
+#endif
+
+// Result of a kernel
+//
+struct result_t {
+  std::string kernel;
+  std::string unit;
+  uidx_t count;     // work items (pairs, samples, bytes)
+  uidx_t checksum;  // FNV-1a over the outputs
+  double seconds;
+};
+
+// FNV-1a (64-bit)
+//
+inline void fnv1a(uidx_t &hash, uidx_t x) {
+  for (int b = 0; b < 8; ++b) {
+    hash ^= (x >> (8*b)) & 0xFF;
+    hash *= 0x100000001B3ULL;
+  }
+}
+#define FNV1A_INIT 0xCBF29CE484222325ULL
+
+// Outputs are rounded before hashing so that the checksums
+// don't depend on the last bits of the math library
+inline uidx_t roundreal(real_t x) {
+  return (uidx_t) std::llround(x*1.0e4);
+}
+
+// Wall clock
+//
+inline double walltime() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**************************************************************************
+* Fixed network setup
+**************************************************************************/
+
+// Two vertex populations and one edge model exercising
+// each connection type and the common state types
+//
+void SetupCore(GeNetCore &core) {
+  core.models.resize(3);
+  core.modmap.clear();
+  core.modmap[std::string("none")] = 0;
+  for (idx_t i = 0; i < 2; ++i) {
+    core.models[i].type = GRAPHTYPE_VTX;
+    core.models[i].modname = std::string("pop") + std::to_string(i);
+    core.models[i].statetype = {RNGTYPE_CONST, RNGTYPE_UNIF};
+    core.models[i].stateparam = {{-65.0}, {-14.0, -12.0}};
+    core.modmap[core.models[i].modname] = i+1;
+  }
+  core.models[2].type = GRAPHTYPE_EDG;
+  core.models[2].modname = std::string("syn");
+  core.models[2].statetype = {RNGTYPE_UNIF, RNGTYPE_NORM, RNGTYPE_BNORM, RNGTYPE_BLIN, RNGTYPE_UNINT};
+  core.models[2].stateparam = {{0.9, 1.1}, {1.0, 0.1}, {0.0, 1.0, 2.0}, {0.05, 1.0, 1.0, 20.0}, {0.0, 10.0, 0.5}};
+  core.models[2].sticktype = {RNGTYPE_BLIN, RNGTYPE_UNIF};
+  core.models[2].stickparam = {{0.05, 1.0, 1.0, 20.0}, {1.0, 2.0}};
+  core.modmap[core.models[2].modname] = 3;
+
+  // pop0 -> pop0, pop1 (uniform)
+  // pop1 -> pop0 (sigmoid + uniform)
+  // pop1 -> pop1 (index, no cutoff)
+  core.edges.resize(3);
+  core.edges[0].source = 1;
+  core.edges[0].target = {1, 2};
+  core.edges[0].modidx = 3;
+  core.edges[0].cutoff = 50.0;
+  core.edges[0].conntype = {CONNTYPE_UNIF};
+  core.edges[0].probparam = {{0.1}};
+  core.edges[0].maskparam = {{}};
+  core.edges[1].source = 2;
+  core.edges[1].target = {1};
+  core.edges[1].modidx = 3;
+  core.edges[1].cutoff = 50.0;
+  core.edges[1].conntype = {CONNTYPE_SIG, CONNTYPE_UNIF};
+  core.edges[1].probparam = {{0.5, 25.0, 0.2}, {0.01}};
+  core.edges[1].maskparam = {{}, {}};
+  core.edges[2].source = 2;
+  core.edges[2].target = {2};
+  core.edges[2].modidx = 3;
+  core.edges[2].cutoff = 0.0;
+  core.edges[2].conntype = {CONNTYPE_IDX};
+  core.edges[2].probparam = {{}};
+  core.edges[2].maskparam = {{0, 0, 1, 1}};
+}
+
+
+/**************************************************************************
+* Kernels
+**************************************************************************/
+
+// Connection (all pairs over a fixed placement)
+//
+result_t BenchConnect(idx_t nvtx) {
+  GeNetCore core;
+  SetupCore(core);
+  core.rngine.seed(2032);
+
+  // Fixed placement (uniform in a circle of constant density)
+  std::mt19937 place(7);
+  std::uniform_real_distribution<real_t> unif(0.0, 1.0);
+  real_t radius = std::sqrt(nvtx/(M_PI*0.01));
+  std::vector<real_t> xyz(nvtx*2);
+  std::vector<idx_t> modidx(nvtx), ordidx(nvtx);
+  for (idx_t i = 0; i < nvtx; ++i) {
+    real_t t = 2*M_PI*unif(place);
+    real_t r = radius*std::sqrt(unif(place));
+    xyz[i*2+0] = r*std::cos(t);
+    xyz[i*2+1] = r*std::sin(t);
+    modidx[i] = 1 + (i >= nvtx/2);
+    ordidx[i] = (i >= nvtx/2 ? i - nvtx/2 : i);
+  }
+
+  result_t result;
+  result.kernel = std::string("connect");
+  result.unit = std::string("pairs");
+  result.checksum = FNV1A_INIT;
+  double tstart = walltime();
+  for (idx_t i = 0; i < nvtx; ++i) {
+    for (idx_t j = 0; j < nvtx; ++j) {
+      if (i == j) { continue; }
+      real_t dx = xyz[i*2+0] - xyz[j*2+0];
+      real_t dy = xyz[i*2+1] - xyz[j*2+1];
+      real_t dist = std::sqrt(dx*dx + dy*dy);
+      idx_t edg = core.MakeConnection(modidx[j], modidx[i], ordidx[j], ordidx[i], dist);
+      if (edg) {
+        fnv1a(result.checksum, (uidx_t) (i*nvtx + j));
+        fnv1a(result.checksum, (uidx_t) edg);
+      }
+    }
+  }
+  result.seconds = walltime() - tstart;
+  result.count = core.npairs;
+  fnv1a(result.checksum, (uidx_t) core.nedges);
+
+  return result;
+}
+
+// Connection when appending (a population of a new model joined
+// to pop0 by appended edges, only pairs with an appended vertex)
+//
+result_t BenchAppend(idx_t nvtx, idx_t nnew) {
+  GeNetCore core;
+  SetupCore(core);
+  core.rngine.seed(2032);
+
+  // Appended vertex model and edges pop2 <-> pop0
+  core.models.push_back(core.models[0]);
+  core.models[3].modname = std::string("pop2");
+  core.modmap[core.models[3].modname] = 4;
+  core.edges.resize(5);
+  for (idx_t e = 3; e < 5; ++e) {
+    core.edges[e].modidx = 3;
+    core.edges[e].cutoff = 50.0;
+    core.edges[e].conntype = {CONNTYPE_UNIF};
+    core.edges[e].probparam = {{0.2}};
+    core.edges[e].maskparam = {{}};
+  }
+  core.edges[3].source = 4;
+  core.edges[3].target = {1};
+  core.edges[4].source = 1;
+  core.edges[4].target = {4};
+
+  // Fixed placement (on a line, built populations interleaved,
+  // then the appended one spread over the same line)
+  std::vector<real_t> x(nvtx+nnew);
+  std::vector<idx_t> modidx(nvtx+nnew), ordidx(nvtx+nnew);
+  for (idx_t i = 0; i < nvtx; ++i) {
+    x[i] = (real_t) i;
+    modidx[i] = 1 + (i%2);
+    ordidx[i] = i/2;
+  }
+  for (idx_t i = nvtx; i < nvtx+nnew; ++i) {
+    x[i] = (real_t) ((i-nvtx)*nvtx)/nnew + 0.5;
+    modidx[i] = 4;
+    ordidx[i] = i-nvtx;
+  }
+
+  result_t result;
+  result.kernel = std::string("append");
+  result.unit = std::string("pairs");
+  result.checksum = FNV1A_INIT;
+  double tstart = walltime();
+  for (idx_t i = nvtx; i < nvtx+nnew; ++i) {
+    for (idx_t j = 0; j < nvtx+nnew; ++j) {
+      if (i == j) { continue; }
+      real_t dist = std::fabs(x[i] - x[j]);
+      // edges into and out of the appended vertex
+      idx_t edgin = core.MakeConnection(modidx[j], modidx[i], ordidx[j], ordidx[i], dist);
+      idx_t edgout = core.MakeConnection(modidx[i], modidx[j], ordidx[i], ordidx[j], dist);
+      if (edgin) {
+        fnv1a(result.checksum, (uidx_t) (i*(nvtx+nnew) + j));
+        fnv1a(result.checksum, (uidx_t) edgin);
+      }
+      if (edgout) {
+        fnv1a(result.checksum, (uidx_t) (j*(nvtx+nnew) + i));
+        fnv1a(result.checksum, (uidx_t) edgout);
+      }
+    }
+  }
+  result.seconds = walltime() - tstart;
+  result.count = core.npairs;
+  fnv1a(result.checksum, (uidx_t) core.nedges);
+
+  return result;
+}
+
+// State and stick sampling
+//
+result_t BenchSample(idx_t nsample) {
+  GeNetCore core;
+  SetupCore(core);
+  core.rngine.seed(2032);
+
+  result_t result;
+  result.kernel = std::string("sample");
+  result.unit = std::string("samples");
+  result.checksum = FNV1A_INIT;
+  uidx_t nvalue = 0;
+  double tstart = walltime();
+  for (idx_t n = 0; n < nsample; ++n) {
+    real_t dist = (real_t) (n%400);
+    std::vector<state_t> state = core.BuildEdgState(3, dist, n, n+1);
+    std::vector<tick_t> stick = core.BuildEdgStick(3, dist, n, n+1);
+    for (std::size_t s = 0; s < state.size(); ++s) {
+      fnv1a(result.checksum, roundreal(state[s]));
+    }
+    for (std::size_t s = 0; s < stick.size(); ++s) {
+      fnv1a(result.checksum, stick[s]/1000);
+    }
+    nvalue += state.size() + stick.size();
+  }
+  result.seconds = walltime() - tstart;
+  result.count = nvalue;
+
+  return result;
+}
+
+// Parsing (adjacency, state, event and csv lines held in memory)
+//
+result_t BenchParse(idx_t nline) {
+  GeNetCore core;
+  SetupCore(core);
+
+  // Fixed input text (same formats as the network files)
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<real_t> unif(0.0, 1.0);
+  std::vector<std::string> adjcyline(nline), stateline(nline), eventline(nline), csvline(nline);
+  char buf[64];
+  uidx_t nbytes = 0;
+  for (idx_t i = 0; i < nline; ++i) {
+    idx_t nadj = 1 + (idx_t) (unif(gen)*40);
+    idx_t adj = (idx_t) (unif(gen)*1000);
+    stateline[i] = core.models[i%2].modname;
+    sprintf(buf, " %.7e %.7e", -65.0, -14.0 + 2.0*unif(gen));
+    stateline[i] += buf;
+    for (idx_t j = 0; j < nadj; ++j) {
+      adj += 1 + (idx_t) (unif(gen)*20);
+      sprintf(buf, "%s%" PRIidx, (j ? " " : ""), adj);
+      adjcyline[i] += buf;
+      if (unif(gen) < 0.2) {
+        stateline[i] += " none";
+      }
+      else {
+        stateline[i] += " syn";
+        for (int s = 0; s < 5; ++s) {
+          sprintf(buf, " %.7e", unif(gen));
+          stateline[i] += buf;
+        }
+        for (int s = 0; s < 2; ++s) {
+          sprintf(buf, " %" PRItickhex, (tick_t) (TICKS_PER_MS*(1.0 + 19.0*unif(gen))));
+          stateline[i] += buf;
+        }
+      }
+    }
+    idx_t nevent = (idx_t) (unif(gen)*4);
+    sprintf(buf, "%" PRIidx, nevent);
+    eventline[i] = buf;
+    for (idx_t e = 0; e < nevent; ++e) {
+      sprintf(buf, " %" PRItickhex " %d %" PRIidx " %" PRIidx, (tick_t) (TICKS_PER_MS*100*unif(gen)), EVENT_SPIKE, i, e);
+      eventline[i] += buf;
+    }
+    for (int c = 0; c < 16; ++c) {
+      sprintf(buf, "%s%.18e", (c ? "," : ""), (unif(gen) < 0.5 ? 0.0 : unif(gen)));
+      csvline[i] += buf;
+    }
+    adjcyline[i] += "\n";
+    stateline[i] += "\n";
+    eventline[i] += "\n";
+    csvline[i] += "\n";
+    nbytes += adjcyline[i].size() + stateline[i].size() + eventline[i].size() + csvline[i].size();
+  }
+
+  result_t result;
+  result.kernel = std::string("parse");
+  result.unit = std::string("bytes");
+  result.checksum = FNV1A_INIT;
+  std::vector<idx_t> adjcy;
+  std::vector<lidx_t> edgmodidx;
+  std::vector<std::vector<state_t>> state;
+  std::vector<std::vector<tick_t>> stick;
+  std::vector<event_t> event;
+  std::unordered_map<idx_t, real_t> row;
+  idx_t nstate = 0, nstick = 0;
+  double tstart = walltime();
+  for (idx_t i = 0; i < nline; ++i) {
+    adjcy.clear();
+    edgmodidx.clear();
+    state.clear();
+    stick.clear();
+    event.clear();
+    row.clear();
+    core.ParseAdjcy(&adjcyline[i][0], adjcy);
+    idx_t modidx = core.ParseState(&stateline[i][0], edgmodidx, state, stick, nstate, nstick);
+    core.ParseEvent(&eventline[i][0], event);
+    core.ParseCSVRow(&csvline[i][0], row);
+    // checksum outputs
+    fnv1a(result.checksum, (uidx_t) modidx);
+    for (std::size_t j = 0; j < adjcy.size(); ++j) {
+      fnv1a(result.checksum, (uidx_t) adjcy[j]);
+    }
+    for (std::size_t j = 0; j < edgmodidx.size(); ++j) {
+      fnv1a(result.checksum, (uidx_t) edgmodidx[j]);
+    }
+    for (std::size_t j = 0; j < state.size(); ++j) {
+      for (std::size_t s = 0; s < state[j].size(); ++s) {
+        fnv1a(result.checksum, roundreal(state[j][s]));
+      }
+      for (std::size_t s = 0; s < stick[j].size(); ++s) {
+        fnv1a(result.checksum, stick[j][s]);
+      }
+    }
+    for (std::size_t e = 0; e < event.size(); ++e) {
+      fnv1a(result.checksum, event[e].diffuse);
+      fnv1a(result.checksum, (uidx_t) event[e].index);
+    }
+    for (idx_t c = 0; c < 16; ++c) {
+      fnv1a(result.checksum, roundreal(row[c]));
+    }
+  }
+  result.seconds = walltime() - tstart;
+  result.count = nbytes;
+  fnv1a(result.checksum, (uidx_t) nstate);
+  fnv1a(result.checksum, (uidx_t) nstick);
+
+  return result;
+}
+
+
+/**************************************************************************
+* Golden checksums
+**************************************************************************/
+
+// Golden file lines: <precision> <localidx> <kernel> <count> <checksum>
+//
+int CheckGolden(const char *filename, const std::vector<result_t> &results) {
+  FILE *pGolden = fopen(filename, "r");
+  if (pGolden == NULL) {
+    printf("Error opening %s for reading\n", filename);
+    return 1;
+  }
+  char prec[32], lidx[32], kernel[32];
+  unsigned long long count, checksum;
+  int nfail = 0;
+  int nfound = 0;
+  while (fscanf(pGolden, "%31s", prec) == 1) {
+    if (prec[0] == '#') {
+      // skip comments
+      while (fgetc(pGolden) != '\n' && !feof(pGolden));
+      continue;
+    }
+    if (fscanf(pGolden, "%31s %31s %llu %llx", lidx, kernel, &count, &checksum) != 4) {
+      printf("Error parsing %s\n", filename);
+      fclose(pGolden);
+      return 1;
+    }
+    if (strcmp(prec, BENCH_PREC) || strcmp(lidx, BENCH_LIDX)) {
+      continue;
+    }
+    for (std::size_t r = 0; r < results.size(); ++r) {
+      if (results[r].kernel == kernel && results[r].count == count) {
+        ++nfound;
+        if (results[r].checksum != checksum) {
+          printf("  FAIL %-8s checksum %016llx (golden %016llx)\n", kernel,
+              (unsigned long long) results[r].checksum, checksum);
+          ++nfail;
+        }
+        else {
+          printf("  ok   %-8s checksum %016llx\n", kernel, checksum);
+        }
+      }
+    }
+  }
+  fclose(pGolden);
+  if (nfound == 0) {
+    printf("  warning: no golden checksums for %s %s at this size\n", BENCH_PREC, BENCH_LIDX);
+  }
+  return (nfail > 0);
+}
+
+// Print results in golden file format
+//
+void PrintGolden(const std::vector<result_t> &results) {
+  for (std::size_t r = 0; r < results.size(); ++r) {
+    printf("%s %s %s %llu %016llx\n", BENCH_PREC, BENCH_LIDX, results[r].kernel.c_str(),
+        (unsigned long long) results[r].count, (unsigned long long) results[r].checksum);
+  }
+}
+
+
+/**************************************************************************
+* Main entry point
+**************************************************************************/
+
+// Main
+//
+int main(int argc, char **argv) {
+  const char *golden = NULL;
+  bool printgolden = false;
+  idx_t scale = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--check") && i+1 < argc) {
+      golden = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--golden")) {
+      printgolden = true;
+    }
+    else if (!strcmp(argv[i], "--scale") && i+1 < argc) {
+      scale = atoll(argv[++i]);
+    }
+    else {
+      printf("Usage: %s [--check golden] [--golden] [--scale n]\n"
+          "  --check  file  compare checksums against a golden file\n"
+          "  --golden       print checksums in golden file format\n"
+          "  --scale  n     multiply problem sizes (golden only at 1)\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // Run kernels
+  std::vector<result_t> results;
+  results.push_back(BenchConnect(2000*scale));
+  results.push_back(BenchAppend(2000*scale, 500*scale));
+  results.push_back(BenchSample(200000*scale));
+  results.push_back(BenchParse(20000*scale));
+
+  if (printgolden) {
+    PrintGolden(results);
+    return 0;
+  }
+
+  // Report throughput
+  printf("Kernel throughput (%s, %s)\n", BENCH_PREC, BENCH_LIDX);
+  for (std::size_t r = 0; r < results.size(); ++r) {
+    double rate = results[r].count/results[r].seconds;
+    if (results[r].unit == "bytes") {
+      printf("  %-8s %12.3f MB/s     (%llu %s in %.3fs)\n", results[r].kernel.c_str(), rate/1.0e6,
+          (unsigned long long) results[r].count, results[r].unit.c_str(), results[r].seconds);
+    }
+    else {
+      printf("  %-8s %12.3f M%s/s (%llu in %.3fs)\n", results[r].kernel.c_str(), rate/1.0e6,
+          results[r].unit.c_str(), (unsigned long long) results[r].count, results[r].seconds);
+    }
+  }
+
+  // Correctness
+  if (golden != NULL) {
+    printf("Checking against %s\n", golden);
+    if (CheckGolden(golden, results)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+#!/bin/bash
+#
+# Copyright (C) 2015 Felix Wang
+#
+# Simulation Tool for Asynchrnous Cortical Streams (stacs)
+#
+# runbench.sh
+# Drives build/part/order over synthetic networks and collects timings
+#
+# usage: bench/runbench.sh [sweep...]
+#   sweeps: quick (default), order, cutoff, mix, pops, files, full
+#
+# environment:
+#   CHARMRUN       launcher (default: ./charmrun ++local)
+#   GENET          genet binary (default: ./genet)
+#   GENBENCH       generator binary (default: bench/genbench)
+#   BENCH_DIR      where networks and results go (default: bench/runs)
+#   BENCH_MAXORDER largest order in the order sweep (default: 1e5, up to 1e8)
+#   BENCH_FILES    netfiles for sweeps that don't vary it (default: 1)
+#   BENCH_MAXFILES largest netfiles in the files sweep (default: nproc)
+#   BENCH_KEEP     keep generated network data (default: no)
+
+CHARMRUN=${CHARMRUN:-"./charmrun ++local"}
+GENET=${GENET:-"./genet"}
+GENBENCH=${GENBENCH:-"bench/genbench"}
+BENCH_DIR=${BENCH_DIR:-"bench/runs"}
+BENCH_MAXORDER=${BENCH_MAXORDER:-100000}
+BENCH_FILES=${BENCH_FILES:-1}
+BENCH_MAXFILES=${BENCH_MAXFILES:-$(nproc 2>/dev/null || echo 1)}
+BENCH_KEEP=${BENCH_KEEP:-no}
+TIME=${TIME:-"/usr/bin/time"}
+MAXORDER=$(awk -v n="$BENCH_MAXORDER" 'BEGIN { printf "%d", n }')
+
+SWEEPS="$@"
+[ -z "$SWEEPS" ] && SWEEPS="quick"
+[ "$SWEEPS" = "full" ] && SWEEPS="order cutoff mix pops files"
+
+for bin in $GENET $GENBENCH $TIME; do
+  if [ ! -x "$bin" ]; then
+    echo "Error: $bin not found (run 'make bench' from the top level)"
+    exit 1
+  fi
+done
+
+mkdir -p "$BENCH_DIR"
+STAMP=$(date +%Y%m%d-%H%M%S)
+CSV="$BENCH_DIR/bench-$STAMP.csv"
+LOG="$BENCH_DIR/bench-$STAMP.log"
+echo "sweep,case,order,npop,cutoff,mix,netfiles,netparts,phase,wall_s,maxrss_kb,edges,edges_per_s_per_core" > "$CSV"
+
+
+##########################################################################
+# Helpers
+##########################################################################
+
+# Extract a value from a perf report
+#   perfphase file name    -> wall time of a phase (as seen by main)
+#   perftotal file name    -> total of a counter over all files
+perfphase() {
+  grep "^    \"$2\": [0-9]" "$1" 2>/dev/null | sed 's/.*": \([0-9.eE+-]*\).*/\1/' | head -1
+}
+perftotal() {
+  grep "^    \"$2\": {" "$1" 2>/dev/null | sed 's/.*"total": \([0-9]*\).*/\1/' | head -1
+}
+
+# Run one benchmark case
+#   runcase sweep order npop cutoff mix netfiles netparts
+runcase() {
+  local sweep=$1 order=$2 npop=$3 cutoff=$4 mix=$5 netfiles=$6 netparts=$7
+  local name="bn-o${order}-p${npop}-c${cutoff}-m${mix//:/_}-f${netfiles}-n${netparts}"
+  local dir="$BENCH_DIR/$name"
+  mkdir -p "$dir"
+
+  if ! $GENBENCH --outdir "$dir" --name "$name" --order "$order" --npop "$npop" \
+      --cutoff "$cutoff" --mix "$mix" --netfiles "$netfiles" --netparts "$netparts" >> "$LOG" 2>&1; then
+    echo "  $name: generator failed (see $LOG)"
+    return
+  fi
+
+  for phase in build part order; do
+    echo "== $name $phase" >> "$LOG"
+    if ! $TIME -f "%e %M" -o "$dir/$phase.time" \
+        $CHARMRUN +p"$netfiles" $GENET "$dir/$name.yml" $phase >> "$LOG" 2>&1; then
+      echo "  $name: $phase failed (see $LOG)"
+      return
+    fi
+    local wall=$(cut -d' ' -f1 "$dir/$phase.time")
+    local rss=$(cut -d' ' -f2 "$dir/$phase.time")
+    local edges="" rate=""
+
+    # Build throughput uses genet's own report
+    if [ $phase = build ]; then
+      local perf="$dir/$name.perf.json"
+      edges=$(perftotal "$perf" edges)
+      local tbuild=$(perfphase "$perf" build)
+      if [ -n "$edges" ] && [ -n "$tbuild" ]; then
+        rate=$(awk -v e="$edges" -v t="$tbuild" -v p="$netfiles" 'BEGIN { if (t > 0) printf "%.1f", e/(t*p) }')
+      fi
+    fi
+
+    echo "$sweep,$name,$order,$npop,$cutoff,$mix,$netfiles,$netparts,$phase,$wall,$rss,$edges,$rate" >> "$CSV"
+    echo "  $name: $phase ${wall}s ${rss}kB ${edges:+$edges edges} ${rate:+($rate edges/s/core)}"
+  done
+
+  # Network data can get large
+  if [ "$BENCH_KEEP" != "yes" ]; then
+    find "$dir" -type f ! -name "*.json" ! -name "*.time" ! -name "*.yml" ! -name "*.model" ! -name "*.graph" -delete
+  fi
+}
+
+
+##########################################################################
+# Sweeps
+##########################################################################
+
+for sweep in $SWEEPS; do
+  echo "Sweep: $sweep"
+  case $sweep in
+    quick)
+      runcase quick 1000 2 50 1:1:0 1 1
+      runcase quick 10000 2 50 1:1:0 1 2
+      ;;
+    order)
+      # Density is held fixed, so the edge count should grow linearly
+      for order in 1000 10000 100000 1000000 10000000 100000000; do
+        [ $order -gt $MAXORDER ] && break
+        runcase order $order 2 50 1:1:0 $BENCH_FILES $BENCH_FILES
+      done
+      ;;
+    cutoff)
+      for cutoff in 25 50 100 200; do
+        runcase cutoff 10000 2 $cutoff 1:1:0 $BENCH_FILES $BENCH_FILES
+      done
+      ;;
+    mix)
+      for mix in 1:0:0 0:1:0 0:0:1 1:1:1; do
+        runcase mix 10000 2 50 $mix $BENCH_FILES $BENCH_FILES
+      done
+      ;;
+    pops)
+      for npop in 1 4 16; do
+        runcase pops 10000 $npop 50 1:1:0 $BENCH_FILES $BENCH_FILES
+      done
+      ;;
+    files)
+      netfiles=1
+      while [ $netfiles -le $BENCH_MAXFILES ]; do
+        runcase files 10000 2 50 1:1:0 $netfiles $((2*netfiles))
+        netfiles=$((2*netfiles))
+      done
+      ;;
+    *)
+      echo "Error: unknown sweep $sweep"
+      exit 1
+      ;;
+  esac
+done
+
+
+##########################################################################
+# Scaling check
+##########################################################################
+
+# Fit the growth exponent of build time between consecutive orders of the
+# order sweep; anything well above linear is flagged
+awk -F, '$1 == "order" && $9 == "build" {
+  if (n0 > 0 && t0 > 0 && $10 > 0) {
+    k = log($10/t0)/log($3/n0)
+    printf "  build %d -> %d: time exponent %.2f%s\n", n0, $3, k, (k > 1.5 ? "  <-- superlinear" : "")
+  }
+  n0 = $3; t0 = $10
+}' "$CSV"
+
+echo "Results in $CSV"
@@ -10,6 +10,7 @@
 #include <mpi.h>
 
 #include <algorithm>
+#include <limits>
 #include <list>
 #include <cmath>
 #include <random>
@@ -21,6 +22,10 @@
 
 #include "typedefs.h"
 #include "timing.h"
+#include "varint.h"
+#include "netcache.h"
+#include "netzip.h"
+#include "netcore.h"
 
 #include <mpi.h>
 #include "mpi-interoperate.h"
@@ -30,68 +35,43 @@
 #include "genet.decl.h"
 
 
-#define GRAPHTYPE_NTYPE 3
-
-#define GRAPHTYPE_STR   0
-#define GRAPHTYPE_VTX   1
-#define GRAPHTYPE_EDG   2
-
-#define RNGTYPE_NRNG    11
-#define REPTYPE_REAL    0
-#define REPTYPE_TICK    1
-
-// TODO: reorder these numbers sometime
-#define RNGTYPE_CONST   0
-#define RNGTYPE_UNIF    1
-#define RNGTYPE_UNINT   2
-#define RNGTYPE_NORM    3
-#define RNGTYPE_BNORM   4
-#define RNGTYPE_LBNORM  5
-#define RNGTYPE_LIN     6
-#define RNGTYPE_LBLIN   7
-#define RNGTYPE_UBLIN   8
-#define RNGTYPE_BLIN    9
-#define RNGTYPE_FILE    10
-
-#define RNGPARAM_CONST  1
-#define RNGPARAM_UNIF   2
-#define RNGPARAM_UNINT  3
-#define RNGPARAM_NORM   2
-#define RNGPARAM_BNORM  3
-#define RNGPARAM_LBNORM 3
-#define RNGPARAM_LIN    2
-#define RNGPARAM_LBLIN  3
-#define RNGPARAM_UBLIN  3
-#define RNGPARAM_BLIN   4
-#define RNGPARAM_FILE   1
-
-#define VTXSHAPE_POINT  0
-#define VTXSHAPE_CIRCLE 1
-#define VTXSHAPE_SPHERE 2
-#define VTXSHAPE_RECT   3
-
-#define VTXPARAM_POINT  0
-#define VTXPARAM_CIRCLE 1
-#define VTXPARAM_SPHERE 1
-#define VTXPARAM_RECT   2
-
-#define CONNTYPE_UNIF   0
-#define PROBPARAM_UNIF  1
-#define MASKPARAM_UNIF  0
-
-#define CONNTYPE_SIG    1
-#define PROBPARAM_SIG   3
-#define MASKPARAM_SIG   0
-
-#define CONNTYPE_IDX    2
-#define PROBPARAM_IDX   0
-#define MASKPARAM_IDX   4
-
-#define CONNTYPE_FILE   3
-#define PROBPARAM_FILE  1
-#define MASKPARAM_FILE  2
-
-#define EVENT_SPIKE     0
+#define PLACEMENT_LOOP  0 // populations spread round robin over parts
+#define PLACEMENT_SLAB  1 // populations split into spatial slabs by part
+
+#define PERF_NTIMER     10
+#define PERF_READ       0
+#define PERF_BUILD      1
+#define PERF_CONNECT    2
+#define PERF_CONNSTEP   3 // longest single connect step
+#define PERF_SCATTER    4
+#define PERF_GATHER     5
+#define PERF_REORDER    6
+#define PERF_ORDER      7
+#define PERF_WRITE      8
+#define PERF_COMM       9
+
+#define PERF_NCOUNT     8
+#define PERF_VTX        0
+#define PERF_PAIRS      1 // vertex pairs evaluated for connection (GeNetCore)
+#define PERF_EDGES      2 // edges created (GeNetCore)
+#define PERF_BYTESREAD  3
+#define PERF_BYTESWRITE 4
+#define PERF_BYTESMSG   5 // bytes of connection/part messages sent
+#define PERF_PEAKRSS    6 // peak resident set size (kB)
+#define PERF_HUBS       7 // vertices above hubdegree (when connecting)
+
+// Connectivity statistics (per connection, then per edge model column)
+#define STATS_NBIN      64
+#define STATS_NDEGLIN   32 // degrees binned exactly (then by powers of two)
+#define STATS_NVALEXP   32 // value bins per sign (by powers of two)
+#define STATS_MINEXP    -15 // smallest exponent binned (2^-16 to 2^-15)
+#define STATS_NCONN     4 // records per connection (kinds below)
+#define STATS_INDEG     0 // in-degree of target vertices
+#define STATS_OUTDEG    1 // out-degree of source vertices
+#define STATS_PAIRS     2 // vertex pairs evaluated (by distance)
+#define STATS_CONNS     3 // connections made (by distance)
+#define STATS_STATE     4 // edge state values (by sign and power of two)
+#define STATS_STICK     5 // edge stick values in ms (as states)
 
 
 /**************************************************************************
@@ -103,6 +83,21 @@
 void registerNetDist(void);
 CkReductionMsg *netDist(int nMsg, CkReductionMsg **msgs);
 
+// Performance instrumentation
+//
+void registerNetPerf(void);
+CkReductionMsg *netPerf(int nMsg, CkReductionMsg **msgs);
+
+// Partition quality
+//
+void registerNetQual(void);
+CkReductionMsg *netQual(int nMsg, CkReductionMsg **msgs);
+
+// Connectivity statistics
+//
+void registerNetStats(void);
+CkReductionMsg *netStats(int nMsg, CkReductionMsg **msgs);
+
 // Model Information
 //
 #define MSG_Model 11
@@ -125,7 +120,7 @@ class mModel : public CMessage_mModel {
     idx_t ndatafiles;
 };
 
-#define MSG_Graph 17
+#define MSG_Graph 21
 class mGraph : public CMessage_mGraph {
   public:
     idx_t *vtxmodidx;     // Which vertex to build (modidx from modmap)
@@ -145,6 +140,10 @@ class mGraph : public CMessage_mGraph {
     real_t *edgprobparam; // connection probability parameters
     idx_t *medgmaskparam; // connection mask sizes
     idx_t *edgmaskparam;  // connection mask parameters
+    idx_t *evttype;       // event generator type
+    idx_t *xevttarget;    // event target prefix
+    idx_t *evttarget;     // target modidx of event generator
+    real_t *evtparam;     // rate, tstart, tstop of event generator
     idx_t nvtx;
     idx_t nvtxparam;
     idx_t nedg;
@@ -152,19 +151,33 @@ class mGraph : public CMessage_mGraph {
     idx_t nedgconntype;
     idx_t nedgprobparam;
     idx_t nedgmaskparam;
+    idx_t nevt;
+    idx_t nevttarget;
+    idx_t nvtxbase;       // entries of the built network (appending)
+    idx_t nedgbase;
+    idx_t nevtbase;
 };
 
-#define MSG_Conn 6
+#define MSG_Conn 14
 class mConn : public CMessage_mConn {
   public:
     idx_t *vtxmodidx;   // vertex model
     idx_t *vtxordidx;   // vertex model order
-    real_t *xyz;        // vertex coordinates
+    coord_t *xyz;       // vertex coordinates
     idx_t *xadj;        // prefix for adjacency
-    idx_t *adjcy;       // adjacent vertices
-    idx_t *edgmodidx;   // edge models
+    idx_t *xadjcy;      // prefix for adjacency bytes
+    uint8_t *adjcy;     // adjacent vertices (delta varint)
+    lidx_t *edgmodidx;   // edge models
+    idx_t *outdeg;      // out-degree of requesting vertices (statistics)
+    idx_t *hubvtx;      // hub vertices of the sender (segment kept by the receiver)
+    idx_t *xhubadj;     // prefix for hub edges
+    idx_t *hubadjcy;    // hub edges (by vtxidx)
+    lidx_t *hubedgmodidx; // hub edge models
+    state_t *hubstate;  // hub edge states
+    tick_t *hubstick;   // hub edge sticks
     idx_t datidx;
     idx_t nvtx;
+    idx_t nhub;
 };
 
 #define MSG_Metis 2
@@ -174,16 +187,17 @@ class mMetis : public CMessage_mMetis {
     idx_t *edgdist; // number of edges in data
 };
   
-#define MSG_Part 14
+#define MSG_Part 15
 class mPart : public CMessage_mPart {
   public:
     idx_t *vtxidx;
     idx_t *vtxmodidx;
-    real_t *xyz;
+    coord_t *xyz;
     idx_t *xadj;
-    idx_t *adjcy;
-    idx_t *edgmodidx;
-    real_t *state;
+    idx_t *xadjcy;
+    uint8_t *adjcy;
+    lidx_t *edgmodidx;
+    state_t *state;
     tick_t *stick;
     idx_t *xevent;
     tick_t *diffuse;
@@ -197,16 +211,32 @@ class mPart : public CMessage_mPart {
     idx_t nstate;
     idx_t nstick;
     idx_t nevent;
+    idx_t segidx; // segment of a hub vertex (0 for the part itself)
+    idx_t nseg;   // segments split off the part
 };
   
-#define MSG_Order 2
+#define MSG_Order 3
 class mOrder : public CMessage_mOrder {
   public:
     idx_t *vtxidxold;
-    idx_t *vtxidxnew;
+    lidx_t *vtxidxnew;
+    idx_t *norderprt;
     idx_t datidx;
     idx_t nvtx;
 };
+
+// Communication maps
+//
+#define MSG_Comm 4
+class mComm : public CMessage_mComm {
+  public:
+    idx_t *prtidx; // pairs of (sending part, receiving part)
+    idx_t *xadj;
+    idx_t *xadjcy;
+    uint8_t *adjcy;
+    idx_t datidx;
+    idx_t ncomm;
+};
   
 
 
@@ -214,47 +244,6 @@ class mOrder : public CMessage_mOrder {
 * Data Structures
 **************************************************************************/
 
-// Model
-//
-struct model_t {
-  idx_t type;
-  std::string modname;
-  std::vector<idx_t> statetype;
-  std::vector<std::vector<real_t>> stateparam;
-  std::vector<idx_t> sticktype;
-  std::vector<std::vector<real_t>> stickparam;
-};
-
-// Vertices
-//
-struct vertex_t {
-  idx_t modidx;
-  idx_t order;
-  idx_t shape;
-  std::vector<real_t> param;
-  std::vector<real_t> coord;
-};
-
-// Edges
-//
-struct edge_t {
-  idx_t source;
-  std::vector<idx_t> target;
-  idx_t modidx;
-  real_t cutoff;
-  std::vector<idx_t> conntype;
-  std::vector<std::vector<real_t>> probparam;
-  std::vector<std::vector<idx_t>> maskparam;
-};
-
-// Data files
-//
-struct datafile_t {
-  std::string filename;
-  // Sparse matrix (can also be used as a vector)
-  std::vector<std::unordered_map<idx_t, real_t>> matrix;
-};
-
 // Size Distributions
 //
 struct dist_t {
@@ -270,26 +259,116 @@ struct dist_t {
   }
 };
 
-// Events
+// Performance
 //
-struct event_t {
-  tick_t diffuse;
-  idx_t type;
-  idx_t source;
-  idx_t index;
-  real_t data;
-  
-  bool operator<(const event_t& event) const {
-    return diffuse < event.diffuse;
+struct perf_t {
+  idx_t datidx;
+  real_t timer[PERF_NTIMER];
+  idx_t count[PERF_NCOUNT];
+
+  bool operator<(const perf_t& perf) const {
+    return datidx < perf.datidx;
   }
 };
 
+// Partition quality (per part)
+//
+struct qual_t {
+  idx_t prtidx;
+  idx_t nvtx;
+  idx_t nedg;    // real edges (into the part)
+  idx_t nstate;  // state and stick values (vertices and edges)
+  idx_t nedgext; // real edges from other parts (cut)
+  idx_t nrecv;   // distinct vertices received from other parts
+  idx_t nnbr;    // neighboring parts
+  idx_t nbdry;   // vertices adjacent to other parts
+
+  bool operator<(const qual_t& qual) const {
+    return prtidx < qual.prtidx;
+  }
+};
+
+// Connectivity statistics (mergeable)
+//
+struct stat_t {
+  idx_t kind;
+  idx_t key[3]; // source, target and edge model (or edge model and column)
+  idx_t count;
+  double sum;
+  double sumsq;
+  double min;
+  double max;
+  double width; // of distance bins
+  idx_t bin[STATS_NBIN];
+};
+
+// Statistics bins
+//   degrees are exact up to STATS_NDEGLIN, then by powers of two
+inline idx_t statdegbin(idx_t deg) {
+  if (deg < STATS_NDEGLIN) {
+    return deg;
+  }
+  idx_t bin = STATS_NDEGLIN;
+  for (idx_t d = deg/STATS_NDEGLIN; d > 1 && bin < STATS_NBIN-1; d >>= 1) {
+    ++bin;
+  }
+  return bin;
+}
+//   values by sign and power of two (smaller magnitudes in the innermost)
+inline idx_t statvalbin(double val) {
+  int exp = STATS_MINEXP;
+  if (val != 0.0) {
+    std::frexp(val, &exp);
+  }
+  idx_t bin = std::min(std::max(exp - STATS_MINEXP, 0), STATS_NVALEXP-1);
+  return (val < 0.0 ? STATS_NVALEXP-1 - bin : STATS_NVALEXP + bin);
+}
+// Add a value
+inline void statadd(stat_t &stat, double val, idx_t bin) {
+  if (stat.count == 0 || val < stat.min) { stat.min = val; }
+  if (stat.count == 0 || val > stat.max) { stat.max = val; }
+  ++stat.count;
+  stat.sum += val;
+  stat.sumsq += val*val;
+  ++stat.bin[bin];
+}
+// Merge statistics
+inline void statmerge(stat_t &stat, const stat_t &other) {
+  if (other.count) {
+    if (stat.count == 0 || other.min < stat.min) { stat.min = other.min; }
+    if (stat.count == 0 || other.max > stat.max) { stat.max = other.max; }
+  }
+  stat.count += other.count;
+  stat.sum += other.sum;
+  stat.sumsq += other.sumsq;
+  for (idx_t b = 0; b < STATS_NBIN; ++b) {
+    stat.bin[b] += other.bin[b];
+  }
+}
+
+// Real edges of a vertex (entries other than 'none')
+//
+inline idx_t edgdegree(const std::vector<lidx_t> &edgmodidx) {
+  return edgmodidx.size() - std::count(edgmodidx.begin(), edgmodidx.end(), 0);
+}
+
+// Scoped timer (accumulates into a perf timer)
+//
+struct perftimer_t {
+  real_t &timer;
+  real_t tstart;
+
+  perftimer_t(real_t &t) : timer(t), tstart(CkWallTimer()) { }
+  ~perftimer_t() { timer += CkWallTimer() - tstart; }
+  real_t elapsed() const { return CkWallTimer() - tstart; }
+};
+
 // Vertex ordering
 //
 struct vtxorder_t {
   idx_t modidx;
   idx_t vtxidx;
-  idx_t vtxidxloc; // local index of vertex
+  lidx_t vtxidxloc; // local index of vertex
   bool operator < (const vtxorder_t& vtx) const {
     return (modidx < vtx.modidx);
   }
@@ -299,8 +378,8 @@ struct vtxorder_t {
 //
 struct edgorder_t {
   idx_t edgidx;
-  idx_t modidx;
-  std::vector<real_t> state;
+  lidx_t modidx;
+  std::vector<state_t> state;
   std::vector<tick_t> stick;
   idx_t evtidx;
   bool operator < (const edgorder_t& edg) const {
@@ -308,6 +387,32 @@ struct edgorder_t {
   }
 };
 
+// Event sources (for reordering)
+//
+struct evtsource_t {
+  idx_t source; // source vertex (before reordering)
+  idx_t evtidx; // event in the pool
+  bool operator < (const evtsource_t& evt) const {
+    return (source < evt.source || (source == evt.source && evtidx < evt.evtidx));
+  }
+};
+
+// Checkpointed as plain data
+PUPbytes(event_t)
+PUPbytes(vtxorder_t)
+PUPbytes(stat_t)
+
+// Checkpoints (of a data file)
+#define CKPT_VERSION    2
+#define CKPT_CONN       0 // connecting (after placement and steps)
+#define CKPT_PACK       1 // packed connections to a later file
+#define CKPT_ORDER      2 // gathered parts (before reordering)
+
+// Initial distribution of vertices over the parts
+//
+void OrderNet(const std::vector<vertex_t> &vertices,
+    std::vector<std::vector<idx_t>> &nordernet, std::vector<std::vector<idx_t>> &xordernet);
+
 /**************************************************************************
 * Charm++ Mainchare
 **************************************************************************/
@@ -324,13 +429,30 @@ class Main : public CBase_Main {
     void Control();
     void ReturnControl();
     void Halt(CkReductionMsg *msg);
+    void Report(CkReductionMsg *msg);
+    void QualReport(CkReductionMsg *msg);
+    void StatsReport(CkReductionMsg *msg);
 
     /* Persistence */
     int ParseConfig(std::string configfile);
     int ReadModel();
-    int ReadGraph();
+    int ReadGraph(const std::string &graphbase, bool append);
     int ReadMetis();
+    int ReadDist();
     int WriteDist();
+    int WritePerf();
+    int WriteQual();
+    int WriteStats();
+    void HashNetwork();
+    int ReadCache();
+    int WriteCache();
+    int WriteHash();
+    int OpenCkpt(const std::string &phase, const std::string &key);
+    bool FoundCkpt(int kind);
+    void ClearCkpt();
+    std::string HashParts();
+    int CheckAppend();
+    int Estimate();
 
     mModel* BuildModel();
     mGraph* BuildGraph();
@@ -346,18 +468,38 @@ class Main : public CBase_Main {
     /* Graph information */
     std::vector<vertex_t> vertices;
     std::vector<edge_t> edges;
+    std::vector<evtgen_t> evtgens;
     std::vector<std::string> graphtype;
     /* Persistence */
     std::vector<dist_t> netdist;
     std::vector<idx_t> vtxdist;
     std::vector<idx_t> edgdist;
+    /* Instrumentation */
+    std::vector<perf_t> netperf;
+    std::vector<std::string> phasename;
+    std::vector<real_t> phasetime; // start of phase (wall clock)
+    std::vector<qual_t> netqual;
+    std::vector<stat_t> netstat;
+    /* Build cache */
+    std::string cachedir;
+    std::string netkey;  // hash of all inputs of the build
+    std::string connkey; // hash of the inputs that determine connectivity
+    /* Appending */
+    std::string fileappend; // graph appended to the built network
+    std::size_t nvtxbase; // entries of the built network (the rest are appended)
+    std::size_t nedgbase;
+    std::size_t nevtbase;
     /* Bookkeeping */
     std::string mode;
     bool buildflag;
     bool partsflag;
     bool metisflag;
     bool orderflag;
+    bool commsflag;
+    bool qualsflag;
     bool writeflag;
+    bool statsflag;
+    bool ckptflag; // gathered parts are read from checkpoints
 };
 
 
@@ -367,7 +509,7 @@ class Main : public CBase_Main {
 
 // Generate Network
 //
-class GeNet : public CBase_GeNet {
+class GeNet : public CBase_GeNet, public GeNetCore {
   public:
     /* Constructors and Destructors */
     GeNet(mModel *msg);
@@ -376,6 +518,10 @@ class GeNet : public CBase_GeNet {
 
     /* Build Network */
     void Build(mGraph *msg);
+    void UnpackGraph(mGraph *msg);
+    void LayoutNet(std::vector<std::vector<idx_t>> &nordernet);
+    void PlaceVertex(std::size_t vtxidx, idx_t ordidx, coord_t *coord);
+    void PrepareConn();
     void Connect(mConn *msg);
 
     void ConnRequest(idx_t reqidx);
@@ -389,182 +535,197 @@ class GeNet : public CBase_GeNet {
     void Read(mMetis *msg);
     void ScatterPart();
     void GatherPart(mPart *msg);
+    void GatherEdge(idx_t prtidx, idx_t ivtx, mPart *msg, idx_t i, idx_t &jstate, idx_t &jstick);
+    void MergePart();
+    mPart* BuildPart(idx_t prtidx, const std::vector<idx_t> &ivtx, const std::vector<idx_t> &xedg,
+        const std::vector<idx_t> &nedg, const std::vector<idx_t> &xstate, idx_t segidx);
+    void StartOrder();
+    void ResumeOrder();
+    void PrepareOrder();
     void Order(mOrder *msg);
     void Reorder(mOrder *msg);
+    void ReorderEvent();
     mOrder* BuildOrder();
 
+    /* Communication Maps */
+    void CommMap();
+    void CommRecv(mComm *msg);
+    void CommDone();
+    int WriteComm();
+
+    /* Regenerate State */
+    void Restate(mMetis *msg);
+    void WriteState(const CkCallback &cb);
+
+    /* Append to Network */
+    void Append(mGraph *msg);
+    int ReadAppend(std::vector<std::vector<event_t>> &eventbase);
+    void AppendConn(mConn *msg);
+    void AppendPair(idx_t i, idx_t j, idx_t cpidx, idx_t jmodidx, idx_t jordidx, const coord_t *jxyz, bool full);
+    void AppendEdge(idx_t i, idx_t vtxidx, idx_t modidx, real_t dist, idx_t ordidx);
+    void AppendFlags(idx_t cpidx, std::vector<char> &vtxflag);
+    idx_t AppendIdx(idx_t vtxidx);
+    bool AppendReach(idx_t cpidx);
+    void MergeAppend();
+
     /* Write Network */
     void Write(const CkCallback &cb);
+    void WriteNet();
+    void WriteStateLine(FILE *pState, idx_t jvtxidx, dist_t &rdist);
+
+    /* Instrumentation */
+    void Profile(const CkCallback &cb);
+    void Quality(const CkCallback &cb);
+    void QualRecv(mComm *msg);
+    void QualDone();
+    void Stats(const CkCallback &cb);
+
+    /* Checkpoints */
+    int WriteCkpt(int kind, idx_t reqidx);
+    int ReadCkpt(int kind, idx_t reqidx);
+    int PupCkpt(PUP::er &p, int kind, idx_t reqidx);
 
     /* Connections */
+    void PackConn(idx_t reqidx);
     mConn* BuildPrevConn(idx_t reqidx);
     mConn* BuildCurrConn();
     mConn* BuildNextConn();
-    idx_t MakeConnection(idx_t source, idx_t target, idx_t sourceidx, idx_t targetidx, real_t dist);
-    std::vector<real_t> BuildEdgState(idx_t modidx, real_t dist, idx_t sourceidx, idx_t targetidx);
-    std::vector<tick_t> BuildEdgStick(idx_t modidx, real_t dist, idx_t sourceidx, idx_t targetidx);
-
-    /* Helper Functions */
-    idx_t strtomodidx(const char* nptr, char** endptr) {
-      const char *s;
-      char c;
-      int any;
-      idx_t modidx = IDX_T_MAX;
-      std::string name;
-      // get rid of leading spaces
-      s = nptr;
-      do {
-        c = *s++;
-      } while (isspace(c));
-      // read until space or end of line
-      for (;; c = *s++) {
-        // check for valid characters
-        if (std::isalnum(c) || c == '_')
-          name.append(&c,1);
-        else
-          break;
-      }
-      // If model exists, set it
-      any = 0;
-      if (modmap.find(name) != modmap.end()) {
-        modidx = modmap[name];
-        any = 1;
-      }
-      if (endptr != NULL)
-        *endptr = (char *)(any ? s - 1 : nptr);
-      return (modidx);
-    }
-    // Compute sigmoid
-    real_t sigmoid(real_t x, real_t maxprob, real_t midpoint, real_t slope) {
-      return maxprob * (1.0 - 1.0/(1.0 + std::exp( -slope * (x - midpoint) )));
-    }
-    // RNG State constant
-    real_t rngconst(real_t *param) {
-      return param[0];
-    }
-    // RNG State uniform
-    real_t rngunif(real_t *param) {
-      return param[0] + (param[1] - param[0])*((*unifdist)(rngine));
-    }
-    // RNG State uniform interval
-    real_t rngunint(real_t *param) {
-      return param[0] + param[2] * std::floor((((param[1] - param[0])/param[2])+1)*((*unifdist)(rngine)));
-    }
-    // RNG State normal
-    real_t rngnorm(real_t *param) {
-      return param[0] + (std::abs(param[1]))*((*normdist)(rngine));
-    }
-    // RNG State bounded normal
-    real_t rngbnorm(real_t *param) {
-      real_t state = (*normdist)(rngine);
-      real_t bound = std::abs(param[2]);
-      if (state > bound) { state = bound; }
-      else if (state < -bound) { state = -bound; }
-      return param[0] + (std::abs(param[1]))*state;
-    }
-    // RNG State lower bounded normal
-    real_t rnglbnorm(real_t *param) {
-      real_t state = (*normdist)(rngine);
-      state = param[0] + (std::abs(param[1]))*state;
-      if (state < param[2]) { state = param[2]; }
-      return state;
-    }
-    // RNG State linear
-    real_t rnglin(real_t *param, real_t dist) {
-      return dist*param[0] + param[1];
-    }
-    // RNG State lower bounded linear
-    real_t rnglblin(real_t *param, real_t dist) {
-      real_t state = dist*param[0] + param[1];
-      if (state < param[2]) {
-        state = param[3];
-      }
-      return state;
-    }
-    // RNG State bounded linear
-    real_t rngblin(real_t *param, real_t dist) {
-      real_t state = dist*param[0] + param[1];
-      if (state < param[2]) {
-        state = param[2];
-      }
-      if (state > param[3]) {
-        state = param[3];
-      }
-      return state;
-    }
-    // From datafile
-    // (currently conforms to numpy savetxt format for csv)
-    // Dimensions are stored: targetdim x sourcedim
-    real_t rngfile(real_t *param, idx_t sourceidx, idx_t targetidx) {
-      real_t state = 0.0;
-      if (targetidx >= datafiles[(idx_t) (param[0])].matrix.size() ||
-          datafiles[(idx_t) (param[0])].matrix[targetidx].find(sourceidx) ==
-          datafiles[(idx_t) (param[0])].matrix[targetidx].end()) {
-        // TODO: Throw an error if element doesn't exist
-        CkPrintf("  error: datafile %s does not have element %" PRIidx ", %" PRIidx "\n",
-                 datafiles[(idx_t) (param[0])].filename.c_str(), sourceidx, targetidx);
-      } else {
-        state = datafiles[(idx_t) (param[0])].matrix[targetidx][sourceidx];
-      }
-      return state;
-    }
+    void ConnNext();
+    void CountHubs();
+    void SplitHub(idx_t cpidx);
+    mConn* BuildHubConn(idx_t cpidx);
+    void CopyHub(mConn *mconn, idx_t cpidx);
+    void HubReturn(mConn *msg);
+    void MergeHub(mConn *msg);
+    int HubKept();
+    void StatsLayout();
+    void StatConn(idx_t source, idx_t target, real_t dist, idx_t modidx, idx_t *outdeg);
+    void StatEdge(idx_t target, idx_t source, idx_t modidx,
+        const std::vector<state_t> &edgstate, const std::vector<tick_t> &edgstick, idx_t *indeg);
+    bool SkipConn(idx_t cpidx);
+    void SlabExtent(idx_t vtxidx, idx_t xorder, idx_t norder, real_t *bbox);
+
+    /* Errors */
+    void Abort();
 
   private:
     /* Network Data */
     std::vector<idx_t> vtxdist;
-    std::vector<real_t> xyz;
-    std::vector<std::vector<idx_t>> adjcy;
-    std::vector<std::vector<std::vector<real_t>>> state;
+    std::vector<coord_t> xyz;
+    std::vector<std::vector<idx_t>> adjcy; // plain indices (encoded in flight, see varint.h)
+    std::vector<std::vector<std::vector<state_t>>> state;
         // first level is the vertex, second level is the models, third is state data
     std::vector<std::vector<std::vector<tick_t>>> stick;
-    std::vector<std::vector<event_t>> event;
+    std::vector<event_t> event; // event pool (by vertex, each sorted by diffuse)
+    std::vector<idx_t> xevent;  // event prefix (by vertex)
     /* Models */
-    std::vector<model_t> models;
     std::vector<std::string> modname;     // model names in order of object index
-    std::unordered_map<std::string, idx_t> modmap; // maps model name to object index
-    std::vector<std::string> rngtype;     // rng types in order of definitions
     std::vector<idx_t> vtxmodidx; // vertex model index into netmodel
     std::vector<idx_t> vtxordidx; // vertex index within model order
-    std::vector<std::vector<idx_t>> edgmodidx; // edge model index into netmodel
-    std::vector<datafile_t> datafiles;
+    std::vector<std::vector<lidx_t>> edgmodidx; // edge model index into netmodel
     /* Connection information */
-    std::vector<std::vector<std::vector<idx_t>>> adjcyconn;
+    std::vector<std::vector<std::vector<lidx_t>>> adjcyconn;
         // first level is the data parts, second level are per vertex, third level is edges
     std::list<idx_t> adjcyreq; // parts that are requesting thier adjacency info
-    std::vector<std::vector<std::vector<idx_t>>> edgmodidxconn; // edge model index into netmodel
+    std::vector<std::vector<std::vector<lidx_t>>> edgmodidxconn; // edge model index into netmodel
         // first level is the data parts, second level are per vertex, third level is edges
+    std::vector<std::vector<idx_t>> xadjpack; // adjacency prefix (packed once built)
+    std::vector<std::vector<idx_t>> xadjcypack; // adjacency byte prefix (packed once built)
+    std::vector<std::vector<uint8_t>> adjcypack; // adjacency (delta varint)
+    std::vector<std::vector<lidx_t>> edgmodidxpack; // edge models (packed once built)
+    std::vector<std::vector<idx_t>> outdegpack; // out-degree of later vertices (statistics)
+        // first level is the data parts, second level is flattened over vertices
+    /* Hub segments */
+    std::vector<std::vector<idx_t>> hubvtx; // hub vertices with a segment (by data part)
+        // segments of local hubs go to later parts (kept there until written),
+        // and segments of the hubs of earlier parts are kept here
+    std::vector<std::vector<idx_t>> xhubadj; // prefix of segment edges (by hub)
+    std::vector<std::vector<idx_t>> hubadjcy; // segment edges (by vtxidx)
+    std::vector<std::vector<lidx_t>> hubedgmodidx; // segment edge models
+    std::vector<std::vector<state_t>> hubstate; // segment states (flattened over edges)
+    std::vector<std::vector<tick_t>> hubstick;
+    std::vector<idx_t> hubdeg; // real edges of local vertices kept by later parts
+    std::list<mConn *> hubrecv; // segments returned for writing
+    CkCallback writecb;
+    int cphub;
     /* Graph information */
     std::vector<vertex_t> vertices; // vertex models and build information
-    std::vector<edge_t> edges; // edge models and connection information
     /* Metis */
     std::vector<idx_t> vtxdistmetis; // distribution of vertices on data
     std::vector<idx_t> edgdistmetis; // distribution of edges on data
     std::vector<idx_t> partmetis; // which vertex goes to which part
     std::vector<std::vector<idx_t>> vtxidxpart; // vertex indices to go to a part
     std::vector<std::vector<idx_t>> vtxmodidxpart; // vertex models to go to a part
-    std::vector<std::vector<idx_t>> xyzpart; // vertex models to go to a part
+    std::vector<std::vector<coord_t>> xyzpart; // vertex coordinates to go to a part
     std::vector<std::vector<std::vector<idx_t>>> adjcypart; // edge indices (by vtxidx) to go to a part
-    std::vector<std::vector<std::vector<idx_t>>> edgmodidxpart; // edge models to go to a part
-    std::vector<std::vector<std::vector<real_t>>> statepart;
+    std::vector<std::vector<std::vector<lidx_t>>> edgmodidxpart; // edge models to go to a part
+    std::vector<std::vector<std::vector<state_t>>> statepart;
         // first level is the part, second is the models, thrid is state data
     std::vector<std::vector<std::vector<tick_t>>> stickpart;
     std::vector<std::vector<std::vector<event_t>>> eventpart;
     /* Reordering */
     std::vector<std::vector<vtxorder_t>> vtxorder; // modidx and vtxidx for sorting
     std::vector<edgorder_t> edgorder; // edgidx and states for sorting
-    std::vector<std::vector<real_t>> xyzorder; // coordinates by vertex
+    std::vector<std::vector<coord_t>> xyzorder; // coordinates by vertex
     std::vector<std::vector<std::vector<idx_t>>> adjcyorder; // adjacency by vertex
     std::vector<std::vector<std::vector<idx_t>>> adjcyreorder; // adjacency by vertex
-    std::vector<std::vector<std::vector<idx_t>>> edgmodidxorder; // edge models by vertex
-    std::vector<std::vector<std::vector<idx_t>>> edgmodidxreorder; // edge models by vertex
-    std::vector<std::vector<std::vector<std::vector<real_t>>>> stateorder; // state by vertex
-    std::vector<std::vector<std::vector<std::vector<real_t>>>> statereorder; // state by vertex
+    std::vector<std::vector<std::vector<lidx_t>>> edgmodidxorder; // edge models by vertex
+    std::vector<std::vector<std::vector<lidx_t>>> edgmodidxreorder; // edge models by vertex
+    std::vector<std::vector<std::vector<std::vector<state_t>>>> stateorder; // state by vertex
+    std::vector<std::vector<std::vector<std::vector<state_t>>>> statereorder; // state by vertex
     std::vector<std::vector<std::vector<std::vector<tick_t>>>> stickorder; // stick by vertex
     std::vector<std::vector<std::vector<std::vector<tick_t>>>> stickreorder; // stick by vertex
     std::vector<std::vector<std::vector<event_t>>> eventorder; // event by vertex
-    std::vector<std::vector<idx_t>> eventsourceorder; // source reordering
+    std::vector<evtsource_t> eventsource; // event pool keyed by source (by vertex, as xevent)
     std::vector<std::vector<idx_t>> eventindexorder; // index reordering
     std::list<mOrder *> ordering;
+    std::list<mPart *> partseg; // segments of hub vertices (merged once gathered)
+    idx_t cpseg, nsegprt; // segments gathered and split off the gathered parts
+    std::vector<idx_t> vtxdistprt; // distribution of vertices on parts (reordered)
+    /* Communication maps */
+    std::vector<std::vector<idx_t>> commrecvprt; // parts received from (per local part)
+    std::vector<std::vector<std::vector<idx_t>>> commrecv; // vertices received from each
+    std::vector<std::vector<idx_t>> commsendprt; // parts sent to (per local part)
+    std::vector<std::vector<std::vector<idx_t>>> commsend; // vertices sent to each
+    int cpcomm;
+    /* Partition quality */
+    std::vector<qual_t> qual; // metrics (per local part)
+    std::vector<std::vector<idx_t>> qualnbr; // neighboring parts (per local part)
+    std::vector<char> qualbdry; // vertices adjacent to other parts
+    std::list<mComm *> qualrecv; // edges out of this data (directed)
+    CkCallback qualcb;
+    int cpqual;
+    /* Instrumentation */
+    perf_t perf;
+    /* Connectivity statistics */
+    std::vector<stat_t> stats; // records (per connection, then edge model column)
+    std::vector<idx_t> statconn; // connection of a source and target model (-1 for none)
+    std::vector<idx_t> statval;  // first value record of an edge model (-1 for none)
+    std::vector<std::vector<idx_t>> statin;  // connections into a model (by slot)
+    std::vector<std::vector<idx_t>> statout; // connections out of a model (by slot)
+    std::vector<idx_t> statslotin;  // slot of a connection in its target model
+    std::vector<idx_t> statslotout; // slot of a connection in its source model
+    std::vector<idx_t> xstatin;     // prefix of slots (by vertex)
+    std::vector<idx_t> xstatout;
+    std::vector<idx_t> statindeg;   // degree (by vertex and slot)
+    std::vector<idx_t> statoutdeg;
+    real_t statrange; // distance binned (largest cutoff or extent)
+    /* Appending */
+    bool appending; // only pairs with appended vertices or edges are connected
+    std::size_t nvtxbase; // entries of the built network (the rest are appended)
+    std::size_t nedgbase;
+    std::size_t nevtbase;
+    std::vector<idx_t> vtxprtbase; // built vertices prefix (by part)
+    std::vector<idx_t> vtxprtall;  // all vertices prefix (by part)
+    std::vector<std::vector<idx_t>> nbasedat; // built vertices per data (by model)
+    std::vector<idx_t> nnewdat; // appended vertices per data
+    std::vector<char> vtxnew;   // appended vertices (local)
+    std::vector<char> appendpair; // appended edges (by source and target model)
+    std::vector<char> appendmod;  // models of appended edges
+    std::vector<std::vector<idx_t>> adjcyadd; // appended adjacency (merged once connected)
+    std::vector<std::vector<lidx_t>> edgmodidxadd;
+    std::vector<std::vector<std::vector<state_t>>> stateadd;
+    std::vector<std::vector<std::vector<tick_t>>> stickadd;
     /* Bookkeeping */
     int datidx;
     int cpdat;
@@ -575,10 +736,9 @@ class GeNet : public CBase_GeNet {
     std::vector<idx_t> norderprt;  // order of vertices per network part
     std::vector<std::vector<idx_t>> nordervtx;  // order of vertex models 
     std::vector<std::vector<idx_t>> xordervtx;  // prefix of vertex models
-    /* Random Number Generation */
-    std::mt19937 rngine;
-    std::uniform_real_distribution<real_t> *unifdist;
-    std::normal_distribution<real_t> *normdist;
+    std::vector<idx_t> norderdatnet; // order per data (all data files)
+    std::vector<real_t> bboxdatnet; // bounding box per data (min xyz, max xyz)
+    real_t maxcutoff; // largest cutoff (0 if some edge has none)
 };
 
 
@@ -7,20 +7,224 @@
  * partition the network adjacency using the ParMETIS libraries
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <string>
 #include <random>
+#include <vector>
 #include <parmetis.h>
 #include <mpi.h>
 #include "typedefs.h"
+#include "netcache.h"
 
 // Using yaml-cpp (specification version 1.2)
 #include "yaml-cpp/yaml.h"
 
-#define MAXLINE 1280000
+#define MAXLINE 1280000 // initial line buffer (grows as needed)
 #define FILENAMESIZE 256
 
+// Group parts onto nodes
+//
+// Parts that communicate heavily are placed on the same node by
+// partitioning the part (quotient) graph into netnodes groups, and
+// parts are relabeled so that each group is a contiguous block
+// (data files, and so processors, hold contiguous blocks of parts)
+//
+int GeNet_PartNodes(MPI_Comm comm, int netfiles, int datidx, idx_t *vtxdist,
+    idx_t nvtx, idx_t *xadj, idx_t *adjcy, idx_t *part, idx_t netparts, idx_t netnodes, idx_t rngmetis) {
+  // Parts of neighboring vertices
+  //
+  // send (vertex, part) of each edge to the owner of the neighbor
+  std::vector<int> sendcount(netfiles, 0);
+  std::vector<int> recvcount(netfiles);
+  std::vector<int> senddispl(netfiles+1, 0);
+  std::vector<int> recvdispl(netfiles+1, 0);
+  for (idx_t j = 0; j < xadj[nvtx]; ++j) {
+    int owner = std::upper_bound(vtxdist, vtxdist+netfiles+1, adjcy[j]) - vtxdist - 1;
+    sendcount[owner] += 2;
+  }
+  MPI_Alltoall(sendcount.data(), 1, MPI_INT, recvcount.data(), 1, MPI_INT, comm);
+  for (int k = 0; k < netfiles; ++k) {
+    senddispl[k+1] = senddispl[k] + sendcount[k];
+    recvdispl[k+1] = recvdispl[k] + recvcount[k];
+  }
+  std::vector<idx_t> sendedg(senddispl[netfiles]);
+  std::vector<idx_t> recvedg(recvdispl[netfiles]);
+  std::vector<int> jsend(senddispl.begin(), senddispl.end()-1);
+  for (idx_t i = 0; i < nvtx; ++i) {
+    for (idx_t j = xadj[i]; j < xadj[i+1]; ++j) {
+      int owner = std::upper_bound(vtxdist, vtxdist+netfiles+1, adjcy[j]) - vtxdist - 1;
+      sendedg[jsend[owner]++] = adjcy[j];
+      sendedg[jsend[owner]++] = part[i];
+    }
+  }
+  MPI_Alltoallv(sendedg.data(), sendcount.data(), senddispl.data(), IDX_T,
+                recvedg.data(), recvcount.data(), recvdispl.data(), IDX_T, comm);
+  std::vector<idx_t>().swap(sendedg);
+
+  // Edges between parts (both directions are counted)
+  std::vector<std::pair<idx_t, idx_t>> prtedg;
+  for (std::size_t e = 0; e < recvedg.size(); e += 2) {
+    idx_t prtidx = part[recvedg[e] - vtxdist[datidx]];
+    if (prtidx != recvedg[e+1]) {
+      prtedg.push_back(std::make_pair(prtidx, recvedg[e+1]));
+    }
+  }
+  std::vector<idx_t>().swap(recvedg);
+  std::sort(prtedg.begin(), prtedg.end());
+  // triples of (part, part, weight)
+  std::vector<idx_t> prtwgt;
+  for (std::size_t e = 0; e < prtedg.size(); ++e) {
+    if (e && prtedg[e] == prtedg[e-1]) {
+      ++prtwgt.back();
+    }
+    else {
+      prtwgt.push_back(prtedg[e].first);
+      prtwgt.push_back(prtedg[e].second);
+      prtwgt.push_back(1);
+    }
+  }
+  std::vector<std::pair<idx_t, idx_t>>().swap(prtedg);
+
+  // Collect part graph on rank 0
+  int nprtwgt = prtwgt.size();
+  std::vector<int> prtwgtcount(netfiles);
+  std::vector<int> prtwgtdispl(netfiles+1, 0);
+  MPI_Gather(&nprtwgt, 1, MPI_INT, prtwgtcount.data(), 1, MPI_INT, 0, comm);
+  for (int k = 0; k < netfiles; ++k) {
+    prtwgtdispl[k+1] = prtwgtdispl[k] + prtwgtcount[k];
+  }
+  std::vector<idx_t> prtwgtall(datidx == 0 ? prtwgtdispl[netfiles] : 0);
+  MPI_Gatherv(prtwgt.data(), nprtwgt, IDX_T, prtwgtall.data(), prtwgtcount.data(), prtwgtdispl.data(), IDX_T, 0, comm);
+
+  // New labels of the parts
+  std::vector<idx_t> prtlabel(netparts);
+  int result = 0;
+  if (datidx == 0) {
+    // Part graph (merging weights from all ranks)
+    std::vector<std::vector<std::pair<idx_t, idx_t>>> prtadj(netparts);
+    for (std::size_t e = 0; e < prtwgtall.size(); e += 3) {
+      prtadj[prtwgtall[e]].push_back(std::make_pair(prtwgtall[e+1], prtwgtall[e+2]));
+    }
+    std::vector<idx_t>().swap(prtwgtall);
+    std::vector<idx_t> xadjprt(netparts+1, 0);
+    std::vector<idx_t> adjcyprt;
+    std::vector<idx_t> adjwgtprt;
+    for (idx_t p = 0; p < netparts; ++p) {
+      std::sort(prtadj[p].begin(), prtadj[p].end());
+      for (std::size_t j = 0; j < prtadj[p].size(); ++j) {
+        if (adjcyprt.size() > (std::size_t) xadjprt[p] && adjcyprt.back() == prtadj[p][j].first) {
+          adjwgtprt.back() += prtadj[p][j].second;
+        }
+        else {
+          adjcyprt.push_back(prtadj[p][j].first);
+          adjwgtprt.push_back(prtadj[p][j].second);
+        }
+      }
+      xadjprt[p+1] = adjcyprt.size();
+    }
+
+    // Number of parts per node (the parts of its block of files)
+    std::vector<idx_t> capnode(netnodes, 0);
+    std::vector<real_t> tpwgtsnode(netnodes);
+    for (int d = 0; d < netfiles; ++d) {
+      capnode[d/(netfiles/netnodes)] += netparts/netfiles + (d < netparts%netfiles);
+    }
+    std::vector<idx_t> xcapnode(netnodes+1, 0);
+    for (idx_t n = 0; n < netnodes; ++n) {
+      tpwgtsnode[n] = ((real_t) capnode[n])/netparts;
+      xcapnode[n+1] = xcapnode[n] + capnode[n];
+    }
+
+    // Partition parts into nodes
+    std::vector<idx_t> node(netparts, 0);
+    idx_t ncon = 1;
+    idx_t objval = 0;
+    real_t ubvecnode = 1.001;
+    idx_t optionsnode[METIS_NOPTIONS];
+    METIS_SetDefaultOptions(optionsnode);
+    optionsnode[METIS_OPTION_SEED] = rngmetis;
+    if (netnodes > 1 && adjcyprt.size()) {
+      if (METIS_PartGraphKway(&netparts, &ncon, xadjprt.data(), adjcyprt.data(),
+                              NULL, NULL, adjwgtprt.data(), &netnodes,
+                              tpwgtsnode.data(), &ubvecnode, optionsnode,
+                              &objval, node.data()) != METIS_OK) {
+        printf("Error during node partitioning\n");
+        result = 1;
+      }
+    }
+    else {
+      // nothing to group, keep parts in place
+      for (idx_t p = 0; p < netparts; ++p) {
+        node[p] = std::upper_bound(xcapnode.begin(), xcapnode.end(), p) - xcapnode.begin() - 1;
+      }
+    }
+
+    // Nodes must hold exactly their share of parts, move the
+    // parts that lose the least from overfull nodes to the others
+    std::vector<idx_t> nprtnode(netnodes, 0);
+    for (idx_t p = 0; p < netparts; ++p) {
+      ++nprtnode[node[p]];
+    }
+    std::vector<idx_t> wgtnode(netnodes);
+    for (idx_t n = 0; n < netnodes; ++n) {
+      while (nprtnode[n] > capnode[n]) {
+        idx_t pmove = -1, nmove = -1, gmove = 0;
+        for (idx_t p = 0; p < netparts; ++p) {
+          if (node[p] != n) {
+            continue;
+          }
+          std::fill(wgtnode.begin(), wgtnode.end(), 0);
+          for (idx_t j = xadjprt[p]; j < xadjprt[p+1]; ++j) {
+            wgtnode[node[adjcyprt[j]]] += adjwgtprt[j];
+          }
+          for (idx_t m = 0; m < netnodes; ++m) {
+            if (nprtnode[m] < capnode[m] && (pmove < 0 || wgtnode[m] - wgtnode[n] > gmove)) {
+              pmove = p;
+              nmove = m;
+              gmove = wgtnode[m] - wgtnode[n];
+            }
+          }
+        }
+        node[pmove] = nmove;
+        --nprtnode[n];
+        ++nprtnode[nmove];
+      }
+    }
+
+    // Cut between nodes (before and after grouping)
+    idx_t cutflat = 0;
+    idx_t cutnode = 0;
+    for (idx_t p = 0; p < netparts; ++p) {
+      for (idx_t j = xadjprt[p]; j < xadjprt[p+1]; ++j) {
+        idx_t q = adjcyprt[j];
+        // contiguous blocks of parts (same split as above)
+        idx_t pnode = std::upper_bound(xcapnode.begin(), xcapnode.end(), p) - xcapnode.begin() - 1;
+        idx_t qnode = std::upper_bound(xcapnode.begin(), xcapnode.end(), q) - xcapnode.begin() - 1;
+        cutflat += (pnode != qnode) * adjwgtprt[j];
+        cutnode += (node[p] != node[q]) * adjwgtprt[j];
+      }
+    }
+    printf("node edgecut (%" PRIidx " nodes): %" PRIidx " (flat %" PRIidx ")\n", netnodes, cutnode/2, cutflat/2);
+
+    // Relabel parts contiguously by node
+    std::vector<idx_t> xprtnode(xcapnode);
+    for (idx_t p = 0; p < netparts; ++p) {
+      prtlabel[p] = xprtnode[node[p]]++;
+    }
+  }
+  MPI_Bcast(&result, 1, MPI_INT, 0, comm);
+  MPI_Bcast(prtlabel.data(), netparts, IDX_T, 0, comm);
+
+  // Apply labels
+  for (idx_t i = 0; i < nvtx; ++i) {
+    part[i] = prtlabel[part[i]];
+  }
+
+  return result;
+}
+
 int GeNet_Partition(int argc, char ** argv) {
   /* MPI */
   int netfiles, datidx;
@@ -48,6 +252,13 @@ int GeNet_Partition(int argc, char ** argv) {
                      // [1] is information parmetis to output
                      // [2] is the random seed to use
   idx_t rngmetis;
+  int directed;      // adjacency only has real (incoming) edges
+  idx_t netnodes;    // groups of parts (0 for flat, -1 to detect)
+  idx_t hubdegree;   // edges per unit of vertex weight (0 for unit weights)
+  /* Build cache */
+  std::string cachedir;
+  int rngfixed;      // partitions only reused with a fixed rngmetis
+  char cacheentry[FILENAMESIZE];
   /* Sizes */
   idx_t nvtx;
   idx_t nedg;
@@ -59,6 +270,7 @@ int GeNet_Partition(int argc, char ** argv) {
   std::string filebase;
   char filename[FILENAMESIZE];
   char *line;
+  std::size_t nline;
   char *oldstr, *newstr;
   
 
@@ -75,7 +287,7 @@ int GeNet_Partition(int argc, char ** argv) {
   }
   else if (argc == 2) {
     std::string mode = argv[1];
-    if (mode != "build" && mode != "part" && mode != "order") {
+    if (mode != "build" && mode != "part" && mode != "order" && mode != "restate" && mode != "estimate") {
       configfile = argv[1];
     }
     else {
@@ -160,34 +372,153 @@ int GeNet_Partition(int argc, char ** argv) {
     // Random number seed
     try {
       rngmetis = config["rngmetis"].as<idx_t>();
+      rngfixed = 1;
     } catch (YAML::RepresentationException& e) {
       std::random_device rd;
       rngmetis = rd();
+      rngfixed = 0;
       printf("  rngmetis not defined, seeding with: %" PRIidx "\n", rngmetis);
     }
+    // Directed adjacency
+    directed = 0;
+    if (config["directed"]) {
+      try {
+        directed = config["directed"].as<bool>();
+      } catch (YAML::RepresentationException& e) {
+        printf("  directed: %s\n", e.what());
+        return 1;
+      }
+    }
+    // Hub vertices
+    hubdegree = 0;
+    if (config["hubdegree"]) {
+      try {
+        hubdegree = config["hubdegree"].as<idx_t>();
+      } catch (YAML::RepresentationException& e) {
+        printf("  hubdegree: %s\n", e.what());
+        return 1;
+      }
+    }
+    // Node groups
+    netnodes = 0;
+    if (config["netnodes"]) {
+      try {
+        if (config["netnodes"].as<std::string>() == "auto") {
+          netnodes = -1;
+        }
+        else {
+          netnodes = config["netnodes"].as<idx_t>();
+        }
+      } catch (YAML::RepresentationException& e) {
+        printf("  netnodes: %s\n", e.what());
+        return 1;
+      }
+    }
+    // Build cache
+    if (config["cachedir"]) {
+      try {
+        cachedir = config["cachedir"].as<std::string>();
+      } catch (YAML::RepresentationException& e) {
+        printf("  cachedir: %s\n", e.what());
+        return 1;
+      }
+    }
   }
   // Broadcast configuration
   MPI_Bcast(&netparts, 1, IDX_T, 0, comm);
   MPI_Bcast(&rngmetis, 1, IDX_T, 0, comm);
+  MPI_Bcast(&directed, 1, MPI_INT, 0, comm);
+  MPI_Bcast(&netnodes, 1, IDX_T, 0, comm);
+  MPI_Bcast(&hubdegree, 1, IDX_T, 0, comm);
   MPI_Bcast(filename, FILENAMESIZE, MPI_CHAR, 0, comm);
   int filesize = 0;
   while (filename[filesize] != '\0') { ++filesize; }
   filebase.assign(filename, filesize);
 
+  // Count the shared memory nodes
+  if (netnodes < 0) {
+    MPI_Comm nodecomm;
+    int noderank;
+    int nodelead;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, datidx, MPI_INFO_NULL, &nodecomm);
+    MPI_Comm_rank(nodecomm, &noderank);
+    nodelead = (noderank == 0);
+    int nnodes;
+    MPI_Allreduce(&nodelead, &nnodes, 1, MPI_INT, MPI_SUM, comm);
+    MPI_Comm_free(&nodecomm);
+    netnodes = nnodes;
+  }
+  if (netnodes > netparts) {
+    if (datidx == 0) {
+      printf("Error: netnodes (%" PRIidx ") larger than netparts (%" PRIidx ")\n", netnodes, netparts);
+    }
+    return 1;
+  }
+  if (netnodes > 1 && netfiles % netnodes) {
+    if (datidx == 0) {
+      printf("Error: netfiles (%d) not a multiple of netnodes (%" PRIidx ")\n", netfiles, netnodes);
+    }
+    return 1;
+  }
+
   // display some information
   if (datidx == 0) {
     // Display configuration information
     printf("Partition Network for STACS (gepart)\n"
            "Loaded config from %s\n"
            "  Data Files (netfiles):     %d\n"
-           "  Network Parts (netparts):  %" PRIidx "\n",
-           configfile.c_str(), netfiles, netparts);
+           "  Network Parts (netparts):  %" PRIidx "\n"
+           "  Node Groups (netnodes):    %" PRIidx "\n",
+           configfile.c_str(), netfiles, netparts, netnodes);
+  }
+
+  // Cached partition of the same connectivity
+  //   keyed on the build (connkey) and the partitioning options
+  int cachehit = 0;
+  cacheentry[0] = '\0';
+  if (datidx == 0 && cachedir.size() && rngfixed) {
+    sprintf(filename, "%s.hash", filebase.c_str());
+    FILE *pHash = fopen(filename, "r");
+    char connkey[32];
+    if (pHash != NULL) {
+      while (fscanf(pHash, "%31s", connkey) == 1) {
+        if (strcmp(connkey, "connkey") == 0 && fscanf(pHash, "%31s", connkey) == 1) {
+          std::string entry = cachedir + "/" + connkey + "-part-" +
+            std::to_string(netnodes) + "-" + std::to_string(hubdegree) + "-" +
+            std::to_string(rngmetis);
+          if (entry.size() + 32 < FILENAMESIZE) {
+            strcpy(cacheentry, entry.c_str());
+            cachehit = cachefound(entry + "/net.hash");
+          }
+          break;
+        }
+      }
+      fclose(pHash);
+    }
+  }
+  MPI_Bcast(&cachehit, 1, MPI_INT, 0, comm);
+  MPI_Bcast(cacheentry, FILENAMESIZE, MPI_CHAR, 0, comm);
+  if (cachehit) {
+    if (datidx == 0) {
+      printf("Reusing cached partition %s\n", cacheentry);
+    }
+    sprintf(filename, "%s.part.%d", filebase.c_str(), datidx);
+    int linkerr = cachelink(std::string(cacheentry) + "/net.part." + std::to_string(datidx), filename);
+    int cacheerr;
+    MPI_Allreduce(&linkerr, &cacheerr, 1, MPI_INT, MPI_MAX, comm);
+    if (cacheerr == 0) {
+      return 0;
+    }
+    if (datidx == 0) {
+      printf("Error linking partition from cache, partitioning\n");
+    }
   }
  
   // Vertex and Edge distributions
   //
   metisdist = new idx_t[(netfiles+1)*2];
-  line = new char[MAXLINE]; 
+  nline = MAXLINE;
+  line = (char *) malloc(nline);
   if (line == NULL) {
     printf("Error allocating line in\n");
     return 1;
@@ -203,7 +534,7 @@ int GeNet_Partition(int argc, char ** argv) {
       return 1;
     }
     for (int i = 0; i < netfiles+1; ++i) {
-      while(fgets(line, MAXLINE, pDist) && line[0] == '%');
+      while(getline(&line, &nline, pDist) > 0 && line[0] == '%');
       oldstr = line;
       newstr = NULL;
       // vtx
@@ -248,7 +579,7 @@ int GeNet_Partition(int argc, char ** argv) {
   idx_t jadjcy = 0;
   for (idx_t i = 0; i < nvtx; ++i) {
     // Adjacency information
-    while(fgets(line, MAXLINE, pAdjcy) && line[0] == '%');
+    while(getline(&line, &nline, pAdjcy) > 0 && line[0] == '%');
     oldstr = line;
     newstr = NULL;
     for(;;) {
@@ -263,10 +594,11 @@ int GeNet_Partition(int argc, char ** argv) {
     xadj[i+1] = jadjcy;
 
     // vwgt
-    vwgt[i] = 1;
+    // hubs weigh in by their adjacency entries (one vertex per hubdegree)
+    vwgt[i] = 1 + (hubdegree > 0 ? (xadj[i+1]-xadj[i])/hubdegree : 0);
 
     // Coordinates
-    while(fgets(line, MAXLINE, pCoord) && line[0] == '%');
+    while(getline(&line, &nline, pCoord) > 0 && line[0] == '%');
     oldstr = line;
     newstr = NULL;
     for(int j = 0; j < ndims; j++) {
@@ -281,6 +613,65 @@ int GeNet_Partition(int argc, char ** argv) {
   if (datidx == 0) {
     printf("Network order: %" PRIidx "\n", vtxdist[netfiles]);
   }
+
+  // Symmetrize adjacency
+  //
+  // ParMETIS needs every edge in both directions, directed networks
+  // only store incoming edges, so add the reverse of each (j -> i)
+  // to the owner of j
+  if (directed) {
+    std::vector<int> sendcount(netfiles, 0);
+    std::vector<int> recvcount(netfiles);
+    std::vector<int> senddispl(netfiles+1, 0);
+    std::vector<int> recvdispl(netfiles+1, 0);
+    // count reverse edges by owner
+    for (idx_t j = 0; j < nedg; ++j) {
+      int owner = std::upper_bound(vtxdist, vtxdist+netfiles+1, adjcy[j]) - vtxdist - 1;
+      sendcount[owner] += 2;
+    }
+    MPI_Alltoall(sendcount.data(), 1, MPI_INT, recvcount.data(), 1, MPI_INT, comm);
+    for (int k = 0; k < netfiles; ++k) {
+      senddispl[k+1] = senddispl[k] + sendcount[k];
+      recvdispl[k+1] = recvdispl[k] + recvcount[k];
+    }
+    // pairs of (target, source) in global indices
+    std::vector<idx_t> sendedg(senddispl[netfiles]);
+    std::vector<idx_t> recvedg(recvdispl[netfiles]);
+    std::vector<int> jsend(senddispl.begin(), senddispl.end()-1);
+    for (idx_t i = 0; i < nvtx; ++i) {
+      for (idx_t j = xadj[i]; j < xadj[i+1]; ++j) {
+        int owner = std::upper_bound(vtxdist, vtxdist+netfiles+1, adjcy[j]) - vtxdist - 1;
+        sendedg[jsend[owner]++] = adjcy[j];
+        sendedg[jsend[owner]++] = vtxdist[datidx] + i;
+      }
+    }
+    MPI_Alltoallv(sendedg.data(), sendcount.data(), senddispl.data(), IDX_T,
+                  recvedg.data(), recvcount.data(), recvdispl.data(), IDX_T, comm);
+    std::vector<idx_t>().swap(sendedg);
+
+    // merge with the existing adjacency
+    std::vector<std::vector<idx_t>> adjcysym(nvtx);
+    for (idx_t i = 0; i < nvtx; ++i) {
+      adjcysym[i].assign(adjcy + xadj[i], adjcy + xadj[i+1]);
+    }
+    for (std::size_t e = 0; e < recvedg.size(); e += 2) {
+      adjcysym[recvedg[e] - vtxdist[datidx]].push_back(recvedg[e+1]);
+    }
+    std::vector<idx_t>().swap(recvedg);
+    nedg = 0;
+    for (idx_t i = 0; i < nvtx; ++i) {
+      std::sort(adjcysym[i].begin(), adjcysym[i].end());
+      adjcysym[i].erase(std::unique(adjcysym[i].begin(), adjcysym[i].end()), adjcysym[i].end());
+      nedg += adjcysym[i].size();
+    }
+    delete[] adjcy;
+    adjcy = new idx_t[nedg];
+    for (idx_t i = 0; i < nvtx; ++i) {
+      xadj[i+1] = xadj[i] + adjcysym[i].size();
+      std::copy(adjcysym[i].begin(), adjcysym[i].end(), adjcy + xadj[i]);
+    }
+    printf("(nedg symmetric) on %d: %" PRIidx "\n", datidx, nedg);
+  }
   
   // Parmetis Balance
   ubvec = 0.0;
@@ -325,10 +716,21 @@ int GeNet_Partition(int argc, char ** argv) {
     printf("%" PRIidx " on %d: %.12e\n", netparts, netfiles, tstart/netfiles);
   }
 
+  // Group parts by node
+  if (netnodes > 1) {
+    if (datidx == 0) {
+      printf("Grouping parts on %" PRIidx " nodes\n", netnodes);
+    }
+    if (GeNet_PartNodes(comm, netfiles, datidx, vtxdist, nvtx, xadj, adjcy,
+                        part, netparts, netnodes, rngmetis)) {
+      return 1;
+    }
+  }
+
   // Write partitioning
   //
   sprintf(filename,"%s.part.%d", filebase.c_str(),datidx);
-  pPart = fopen(filename,"w");
+  pPart = cachereplace(filename,"w");
   if (pPart == NULL) {
     printf("Error opening partition file\n");
     return 1;
@@ -337,6 +739,26 @@ int GeNet_Partition(int argc, char ** argv) {
     fprintf(pPart, "%" PRIidx "\n", part[i]);
   }
   fclose(pPart);
+
+  // Store partitioning in the cache
+  // (marker goes last, once every part file is in place)
+  if (cacheentry[0] != '\0') {
+    int cacheerr = 0;
+    if (datidx == 0) {
+      cacheerr = cachemkdir(cacheentry);
+    }
+    MPI_Bcast(&cacheerr, 1, MPI_INT, 0, comm);
+    if (cacheerr == 0) {
+      int linkerr = cachelink(filename, std::string(cacheentry) + "/net.part." + std::to_string(datidx));
+      MPI_Allreduce(&linkerr, &cacheerr, 1, MPI_INT, MPI_MAX, comm);
+    }
+    if (datidx == 0) {
+      sprintf(filename, "%s.hash", filebase.c_str());
+      if (cacheerr || cachelink(filename, std::string(cacheentry) + "/net.hash")) {
+        printf("Error storing partition in cache\n");
+      }
+    }
+  }
   
   // Cleanup
   delete[] metisdist;
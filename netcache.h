@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * netcache.h
+ * Content hashing and file linking for the build cache
+ */
+
+#ifndef __STACS_NETCACHE_H__
+#define __STACS_NETCACHE_H__
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "typedefs.h"
+#include "netzip.h"
+
+// Network artifacts are stored in the cache directory under the hash
+// of everything that determines them (entries are never modified once
+// written, so they may be hard linked into the network directory).
+// Hashes are 64-bit FNV-1a over the parsed inputs, so formatting and
+// comments in the yaml files do not change the key. Files are placed
+// into an entry by renaming, and a marker file is placed last, so an
+// entry is only used once it is complete.
+//
+#define NETHASH_INIT    0xcbf29ce484222325ULL
+#define NETHASH_PRIME   0x100000001b3ULL
+#define NETHASH_BUFSIZE 65536
+
+// Hash bytes
+inline uint64_t nethash(const void *data, std::size_t n, uint64_t h) {
+  const unsigned char *pos = (const unsigned char *) data;
+  for (std::size_t i = 0; i < n; ++i) {
+    h = (h ^ pos[i]) * NETHASH_PRIME;
+  }
+  return h;
+}
+// Hash a single value (integers and reals)
+template <typename T>
+inline uint64_t nethashval(T x, uint64_t h) {
+  return nethash(&x, sizeof(T), h);
+}
+// Hash a vector of values (length first)
+template <typename T>
+inline uint64_t nethashvec(const std::vector<T> &v, uint64_t h) {
+  h = nethashval((uidx_t) v.size(), h);
+  return nethash(v.data(), v.size()*sizeof(T), h);
+}
+// Hash a string (length first)
+inline uint64_t nethashstr(const std::string &s, uint64_t h) {
+  h = nethashval((uidx_t) s.size(), h);
+  return nethash(s.data(), s.size(), h);
+}
+
+// Hash the contents of a file
+//
+inline int nethashfile(const char *filename, uint64_t &h) {
+  FILE *pFile = fopen(filename, "rb");
+  if (pFile == NULL) {
+    return 1;
+  }
+  std::vector<char> buf(NETHASH_BUFSIZE);
+  std::size_t n;
+  while ((n = fread(buf.data(), 1, buf.size(), pFile)) > 0) {
+    h = nethash(buf.data(), n, h);
+  }
+  fclose(pFile);
+  return 0;
+}
+
+// Hash as hexadecimal key
+//
+inline std::string nethashkey(uint64_t h) {
+  char key[17];
+  snprintf(key, sizeof(key), "%016" PRIx64, h);
+  return std::string(key);
+}
+
+// Create a directory (and its parents)
+//
+inline int cachemkdir(const std::string &dir) {
+  for (std::size_t pos = 1; pos <= dir.size(); ++pos) {
+    if (pos == dir.size() || dir[pos] == '/') {
+      if (mkdir(dir.substr(0, pos).c_str(), 0777) && errno != EEXIST) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+// Whether a (complete) cache entry exists
+//
+inline bool cachefound(const std::string &marker) {
+  return (access(marker.c_str(), R_OK) == 0);
+}
+
+// Copy a file
+//
+inline int cachecopy(const char *src, const char *dst) {
+  FILE *pSrc = fopen(src, "rb");
+  if (pSrc == NULL) {
+    return 1;
+  }
+  FILE *pDst = fopen(dst, "wb");
+  if (pDst == NULL) {
+    fclose(pSrc);
+    return 1;
+  }
+  std::vector<char> buf(NETHASH_BUFSIZE);
+  std::size_t n;
+  int err = 0;
+  while ((n = fread(buf.data(), 1, buf.size(), pSrc)) > 0) {
+    if (fwrite(buf.data(), 1, n, pDst) != n) {
+      err = 1;
+      break;
+    }
+  }
+  fclose(pSrc);
+  if (fclose(pDst)) {
+    err = 1;
+  }
+  return err;
+}
+
+// Link a file into place (copies across file systems)
+//   the destination is replaced, never written through
+//
+inline int cachelink(const std::string &src, const std::string &dst) {
+  char tmp[32];
+  snprintf(tmp, sizeof(tmp), ".tmp.%ld", (long) getpid());
+  std::string dsttmp = dst + tmp;
+  remove(dsttmp.c_str());
+  if (link(src.c_str(), dsttmp.c_str())) {
+    if (cachecopy(src.c_str(), dsttmp.c_str())) {
+      remove(dsttmp.c_str());
+      return 1;
+    }
+  }
+  if (rename(dsttmp.c_str(), dst.c_str())) {
+    remove(dsttmp.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+// Open a network file for writing
+//   files in the network directory may be hard links into the cache
+//   (see cachelink), and writing through one would change the cached
+//   entry as well, so the old file is removed and a new one is written
+//   (with a level, the file is opened through zipopen)
+//
+inline FILE *cachereplace(const char *filename, const char *mode) {
+  remove(filename);
+  return fopen(filename, mode);
+}
+inline FILE *cachereplace(const char *filename, int level) {
+  remove(filename);
+  return zipopen(filename, "w", level);
+}
+
+#endif //__STACS_NETCACHE_H__
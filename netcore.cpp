@@ -0,0 +1,556 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * netcore.cpp
+ * Network generation kernels (connections, sampling, parsing)
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#include "netcore.h"
+
+
+/**************************************************************************
+* Constructors and Destructors
+**************************************************************************/
+
+// GeNetCore Constructor
+//
+GeNetCore::GeNetCore() {
+  // Set up random number generator
+  // (seeded by the owner)
+  unifdist = new std::uniform_real_distribution<real_t> (0.0, 1.0);
+  normdist = new std::normal_distribution<real_t> (0.0, 1.0);
+
+  // RNG types (for errors)
+  rngtype.resize(RNGTYPE_NRNG);
+  rngtype[RNGTYPE_CONST] = std::string("constant");
+  rngtype[RNGTYPE_UNIF] = std::string("uniform");
+  rngtype[RNGTYPE_UNINT] = std::string("uniform interval");
+  rngtype[RNGTYPE_NORM] = std::string("normal");
+  rngtype[RNGTYPE_BNORM] = std::string("bounded normal");
+  rngtype[RNGTYPE_LBNORM] = std::string("lower bounded normal");
+  rngtype[RNGTYPE_LIN] = std::string("linear");
+  rngtype[RNGTYPE_LBLIN] = std::string("lower bounded linear");
+  rngtype[RNGTYPE_UBLIN] = std::string("upper bounded linear");
+  rngtype[RNGTYPE_BLIN] = std::string("bounded linear");
+  rngtype[RNGTYPE_FILE] = std::string("file");
+
+  // Counters
+  npairs = 0;
+  nedges = 0;
+}
+
+// GeNetCore Destructor
+//
+GeNetCore::~GeNetCore() {
+  delete unifdist;
+  delete normdist;
+}
+
+// Unrecoverable error
+//
+void GeNetCore::Abort() {
+  exit(1);
+}
+
+
+/**************************************************************************
+* Connection Information
+**************************************************************************/
+
+// Make Connection
+//
+idx_t GeNetCore::MakeConnection(idx_t source, idx_t target, idx_t sourceidx, idx_t targetidx, real_t dist) {
+  ++npairs;
+  // Go through edges to find the right connection
+  // TODO: Use an unordered map to do the connection matching
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    if (source == edges[i].source) {
+      for (std::size_t j = 0; j < edges[i].target.size(); ++j) {
+        if (target == edges[i].target[j]) {
+          // test for cutoff
+          if (edges[i].cutoff != 0.0 && dist > edges[i].cutoff) {
+            return 0;
+          }
+          // Connection computation
+          real_t prob = 0.0;
+          idx_t mask = 0;
+          for (std::size_t k = 0; k < edges[i].conntype.size(); ++k) {
+            if (edges[i].conntype[k] == CONNTYPE_UNIF) {
+              prob += edges[i].probparam[k][0];
+            }
+            else if (edges[i].conntype[k] == CONNTYPE_SIG) {
+              prob += sigmoid(dist, edges[i].probparam[k][0],
+                        edges[i].probparam[k][1], edges[i].probparam[k][2]);
+            }
+            else if (edges[i].conntype[k] == CONNTYPE_IDX) {
+              mask += (((sourceidx * edges[i].maskparam[k][2]) + edges[i].maskparam[k][3]) == targetidx);
+            }
+            else if (edges[i].conntype[k] == CONNTYPE_FILE) {
+              // Check to see if it's in the file list
+              // set mask to 1 if there is a non-zero entry
+              // TODO: make sure file-based connections completely override
+              //       other connection types (or make them mutually exclusive)
+              if (sourceidx >= datafiles[(idx_t) (edges[i].probparam[k][0])].matrix.size()) {
+                printf("  error: datafile %s does not have row for %" PRIidx "\n",
+                       datafiles[(idx_t) (edges[i].probparam[k][0])].filename.c_str(), sourceidx);
+              } else if (datafiles[(idx_t) (edges[i].probparam[k][0])].matrix[sourceidx].find(targetidx) ==
+                         datafiles[(idx_t) (edges[i].probparam[k][0])].matrix[sourceidx].end()) {
+                prob = 0.0;
+                mask = 0;
+              } else {
+                mask = 1;
+              }
+            }
+            else {
+              // Shouldn't reach here due to prior error checking
+              printf("  error: connection type %" PRIidx " undefined\n", edges[i].conntype[k]);
+              Abort();
+            }
+          }
+          // Compute probability of connection
+          if ((((*unifdist)(rngine)) < prob) || mask) {
+            ++nedges;
+            return edges[i].modidx;
+          }
+          else {
+            return 0;
+          }
+        }
+      }
+    }
+  }
+
+  // no connection found, return 'none'
+  return 0;
+}
+
+
+/**************************************************************************
+* Vertex State Building
+**************************************************************************/
+
+// States
+//
+std::vector<state_t> GeNetCore::BuildVtxState(idx_t modidx, idx_t vtxidx) {
+  // Sanity check
+  // 0 is reserved for 'none' edge type
+  assert(modidx > 0);
+  --modidx;
+  assert(models[modidx].type == GRAPHTYPE_VTX || models[modidx].type == GRAPHTYPE_STR);
+  // Allocate space for states
+  std::vector<state_t> rngstate;
+  rngstate.resize(models[modidx].statetype.size());
+  // Randomly generate state
+  for (std::size_t s = 0; s < rngstate.size(); ++s) {
+    if (models[modidx].statetype[s] == RNGTYPE_CONST) {
+      rngstate[s] = rngconst(models[modidx].stateparam[s].data());
+    }
+    else if (models[modidx].statetype[s] == RNGTYPE_UNIF) {
+      rngstate[s] = rngunif(models[modidx].stateparam[s].data());
+    }
+    else if (models[modidx].statetype[s] == RNGTYPE_UNINT) {
+      rngstate[s] = rngunint(models[modidx].stateparam[s].data());
+    }
+    else if (models[modidx].statetype[s] == RNGTYPE_NORM) {
+      rngstate[s] = rngnorm(models[modidx].stateparam[s].data());
+    }
+    else if (models[modidx].statetype[s] == RNGTYPE_BNORM) {
+      rngstate[s] = rngbnorm(models[modidx].stateparam[s].data());
+    }
+    else if (models[modidx].statetype[s] == RNGTYPE_FILE) {
+      rngstate[s] = rngfile(models[modidx].stateparam[s].data(), 0, vtxidx);
+    }
+    else {
+      printf("  error: statetype %s is not valid for vertex\n", rngtype[models[modidx].statetype[s]].c_str());
+      // TODO: cleaner error checking here?
+      Abort();
+    }
+  }
+  // return generated state
+  return rngstate;
+}
+
+// Sticks
+//
+std::vector<tick_t> GeNetCore::BuildVtxStick(idx_t modidx, idx_t vtxidx) {
+  // Sanity check
+  // 0 is reserved for 'none' edge type
+  assert(modidx > 0);
+  --modidx;
+  assert(models[modidx].type == GRAPHTYPE_VTX || models[modidx].type == GRAPHTYPE_STR);
+  // Allocate space for sticks
+  std::vector<tick_t> rngstick;
+  rngstick.resize(models[modidx].sticktype.size());
+  // Randomly generate stick
+  for (std::size_t s = 0; s < rngstick.size(); ++s) {
+    if (models[modidx].sticktype[s] == RNGTYPE_CONST) {
+      rngstick[s] = (tick_t)(TICKS_PER_MS * rngconst(models[modidx].stickparam[s].data()));
+    }
+    else if (models[modidx].sticktype[s] == RNGTYPE_UNIF) {
+      rngstick[s] = (tick_t)(TICKS_PER_MS * rngunif(models[modidx].stickparam[s].data()));
+    }
+    else if (models[modidx].sticktype[s] == RNGTYPE_UNINT) {
+      rngstick[s] = (tick_t)(TICKS_PER_MS * rngunint(models[modidx].stickparam[s].data()));
+    }
+    else if (models[modidx].sticktype[s] == RNGTYPE_NORM) {
+      rngstick[s] = (tick_t)(TICKS_PER_MS * rngnorm(models[modidx].stickparam[s].data()));
+    }
+    else if (models[modidx].sticktype[s] == RNGTYPE_BNORM) {
+      rngstick[s] = (tick_t)(TICKS_PER_MS * rngbnorm(models[modidx].stickparam[s].data()));
+    }
+    else if (models[modidx].sticktype[s] == RNGTYPE_FILE) {
+      rngstick[s] = (tick_t)(TICKS_PER_MS * rngfile(models[modidx].stickparam[s].data(), 0, vtxidx));
+    }
+    else {
+      printf("  error: statetype %s is not valid for vertex\n", rngtype[models[modidx].sticktype[s]].c_str());
+      // TODO: cleaner error checking here?
+      Abort();
+    }
+  }
+  // return generated stick
+  return rngstick;
+}
+
+
+/**************************************************************************
+* Edge State Building
+**************************************************************************/
+
+// States
+//
+std::vector<state_t> GeNetCore::BuildEdgState(idx_t modidx, real_t dist, idx_t sourceidx, idx_t targetidx) {
+  // Sanity check
+  // 0 is reserved for 'none' edge type
+  assert(modidx > 0);
+  --modidx;
+  assert(models[modidx].type == GRAPHTYPE_EDG);
+  // Allocate space for states
+  std::vector<state_t> rngstate;
+  rngstate.resize(models[modidx].statetype.size());
+  // Randomly generate state
+  for (std::size_t j = 0; j < rngstate.size(); ++j) {
+    if (models[modidx].statetype[j] == RNGTYPE_CONST) {
+      rngstate[j] = rngconst(models[modidx].stateparam[j].data());
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_UNIF) {
+      rngstate[j] = rngunif(models[modidx].stateparam[j].data());
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_UNINT) {
+      rngstate[j] = rngunint(models[modidx].stateparam[j].data());
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_NORM) {
+      rngstate[j] = rngnorm(models[modidx].stateparam[j].data());
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_BNORM) {
+      rngstate[j] = rngbnorm(models[modidx].stateparam[j].data());
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_LBNORM) {
+      rngstate[j] = rnglbnorm(models[modidx].stateparam[j].data());
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_LIN) {
+      rngstate[j] = rnglin(models[modidx].stateparam[j].data(), dist);
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_LBLIN) {
+      rngstate[j] = rnglblin(models[modidx].stateparam[j].data(), dist);
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_BLIN) {
+      rngstate[j] = rngblin(models[modidx].stateparam[j].data(), dist);
+    }
+    else if (models[modidx].statetype[j] == RNGTYPE_FILE) {
+      rngstate[j] = rngfile(models[modidx].stateparam[j].data(), sourceidx, targetidx);
+    }
+    else {
+      printf("  error: statetype %s is not valid for edge\n", rngtype[models[modidx].statetype[j]].c_str());
+      // TODO: cleaner error checking here?
+      Abort();
+    }
+  }
+  // return generated state
+  return rngstate;
+}
+
+// Sticks
+//
+std::vector<tick_t> GeNetCore::BuildEdgStick(idx_t modidx, real_t dist, idx_t sourceidx, idx_t targetidx) {
+  // Sanity check
+  // 0 is reserved for 'none' edge type
+  assert(modidx > 0);
+  --modidx;
+  assert(models[modidx].type == GRAPHTYPE_EDG);
+  // Allocate space for sticks
+  std::vector<tick_t> rngstick;
+  rngstick.resize(models[modidx].sticktype.size());
+  // Randomly generate stick
+  for (std::size_t j = 0; j < rngstick.size(); ++j) {
+    if (models[modidx].sticktype[j] == RNGTYPE_CONST) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngconst(models[modidx].stickparam[j].data()));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_UNIF) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngunif(models[modidx].stickparam[j].data()));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_UNINT) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngunint(models[modidx].stickparam[j].data()));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_NORM) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngnorm(models[modidx].stickparam[j].data()));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_BNORM) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngbnorm(models[modidx].stickparam[j].data()));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_LBNORM) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rnglbnorm(models[modidx].stickparam[j].data()));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_LIN) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rnglin(models[modidx].stickparam[j].data(), dist));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_LBLIN) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rnglblin(models[modidx].stickparam[j].data(), dist));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_BLIN) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngblin(models[modidx].stickparam[j].data(), dist));
+    }
+    else if (models[modidx].sticktype[j] == RNGTYPE_FILE) {
+      rngstick[j] = (tick_t)(TICKS_PER_MS * rngfile(models[modidx].stickparam[j].data(), sourceidx, targetidx));
+    }
+    else {
+      printf("  error: statetype %s is not valid for edge\n", rngtype[models[modidx].sticktype[j]].c_str());
+      // TODO: cleaner error checking here?
+      Abort();
+    }
+  }
+  // return generated stick
+  return rngstick;
+}
+
+// From datafile
+//
+real_t GeNetCore::rngfile(real_t *param, idx_t sourceidx, idx_t targetidx) {
+  real_t state = 0.0;
+  if (targetidx >= datafiles[(idx_t) (param[0])].matrix.size() ||
+      datafiles[(idx_t) (param[0])].matrix[targetidx].find(sourceidx) ==
+      datafiles[(idx_t) (param[0])].matrix[targetidx].end()) {
+    // TODO: Throw an error if element doesn't exist
+    printf("  error: datafile %s does not have element %" PRIidx ", %" PRIidx "\n",
+           datafiles[(idx_t) (param[0])].filename.c_str(), sourceidx, targetidx);
+  } else {
+    state = datafiles[(idx_t) (param[0])].matrix[targetidx][sourceidx];
+  }
+  return state;
+}
+
+
+/**************************************************************************
+* Event Building
+**************************************************************************/
+
+// Initial events of a vertex
+//   appended to event, sorted by diffuse (spikes on the vertex itself)
+//
+idx_t GeNetCore::BuildVtxEvent(idx_t modidx, idx_t vtxidx, std::mt19937 &evtngine, std::vector<event_t> &event) {
+  std::size_t xevent = event.size();
+  event_t eventpre;
+  eventpre.type = EVENT_SPIKE;
+  eventpre.source = vtxidx;
+  eventpre.index = 0;
+  eventpre.data = 0.0;
+  for (std::size_t g = 0; g < evtgens.size(); ++g) {
+    if (std::find(evtgens[g].target.begin(), evtgens[g].target.end(), modidx) == evtgens[g].target.end() ||
+        evtgens[g].rate <= 0.0) {
+      continue;
+    }
+    if (evtgens[g].type == EVTGEN_POISSON) {
+      // exponential intervals (rate is per second, times in ms)
+      std::exponential_distribution<real_t> isidist(evtgens[g].rate/1000.0);
+      for (real_t t = evtgens[g].tstart + isidist(evtngine); t < evtgens[g].tstop; t += isidist(evtngine)) {
+        eventpre.diffuse = (tick_t)(TICKS_PER_MS * t);
+        event.push_back(eventpre);
+      }
+    }
+    else if (evtgens[g].type == EVTGEN_REGULAR) {
+      // fixed intervals from tstart (counted to avoid drift)
+      real_t isi = 1000.0/evtgens[g].rate;
+      for (idx_t k = 0; evtgens[g].tstart + k*isi < evtgens[g].tstop; ++k) {
+        eventpre.diffuse = (tick_t)(TICKS_PER_MS * (evtgens[g].tstart + k*isi));
+        event.push_back(eventpre);
+      }
+    }
+  }
+  // generators are merged in time
+  std::stable_sort(event.begin() + xevent, event.end());
+  return event.size() - xevent;
+}
+
+
+/**************************************************************************
+* Parsing
+**************************************************************************/
+
+// Model index from name
+//
+idx_t GeNetCore::strtomodidx(const char* nptr, char** endptr) {
+  const char *s;
+  char c;
+  int any;
+  idx_t modidx = IDX_T_MAX;
+  std::string name;
+  // get rid of leading spaces
+  s = nptr;
+  do {
+    c = *s++;
+  } while (isspace(c));
+  // read until space or end of line
+  for (;; c = *s++) {
+    // check for valid characters
+    if (std::isalnum(c) || c == '_')
+      name.append(&c,1);
+    else
+      break;
+  }
+  // If model exists, set it
+  any = 0;
+  std::unordered_map<std::string, idx_t>::const_iterator model = modmap.find(name);
+  if (model != modmap.end()) {
+    modidx = model->second;
+    any = 1;
+  }
+  if (endptr != NULL)
+    *endptr = (char *)(any ? s - 1 : nptr);
+  return (modidx);
+}
+
+// Adjacency (one vertex per line)
+//   appends to adj, returns number of edges read
+//
+idx_t GeNetCore::ParseAdjcy(char *line, std::vector<idx_t> &adj) {
+  char *oldstr = line;
+  char *newstr = NULL;
+  idx_t nadj = 0;
+  for(;;) {
+    idx_t edg = strtoidx(oldstr, &newstr, 10);
+    // check for end of line
+    if (edg == 0 && oldstr != line)
+      break;
+    oldstr = newstr;
+    // adjcy
+    adj.push_back(edg);
+    ++nadj;
+  }
+  return nadj;
+}
+
+// State (vertex followed by its edges on one line)
+//   appends vertex then per edge states to state/stick and
+//   edge models to edgmodidx, returns vertex model index
+//
+idx_t GeNetCore::ParseState(char *line, std::vector<lidx_t> &edgmodidx,
+    std::vector<std::vector<state_t>> &state, std::vector<std::vector<tick_t>> &stick,
+    idx_t &nstate, idx_t &nstick) {
+  char *oldstr = line;
+  char *newstr = NULL;
+  // extract model index from name
+  idx_t vtxmodidx = strtomodidx(oldstr, &newstr);
+  if (vtxmodidx == IDX_T_MAX || vtxmodidx == 0) {
+    return IDX_T_MAX;
+  }
+  oldstr = newstr;
+  idx_t modidx = vtxmodidx;
+  for (;;) {
+    state.push_back(std::vector<state_t>());
+    stick.push_back(std::vector<tick_t>());
+    // only push state if model and not 'none'
+    if (modidx > 0) {
+      for(std::size_t s = 0; s < models[modidx-1].statetype.size(); ++s) {
+        real_t stt = strtoreal(oldstr, &newstr);
+        oldstr = newstr;
+        // state
+        state.back().push_back(stt);
+        ++nstate;
+      }
+      for(std::size_t s = 0; s < models[modidx-1].sticktype.size(); ++s) {
+        tick_t stt = strtotick(oldstr, &newstr, 16);
+        oldstr = newstr;
+        // stick
+        stick.back().push_back(stt);
+        ++nstick;
+      }
+    }
+    // edgmodidx
+    modidx = strtomodidx(oldstr, &newstr);
+    oldstr = newstr;
+    if (modidx == IDX_T_MAX) {
+      break;
+    }
+    edgmodidx.push_back(modidx);
+  }
+  return vtxmodidx;
+}
+
+// Events (one vertex per line)
+//   appends to event, returns number of events read
+//
+idx_t GeNetCore::ParseEvent(char *line, std::vector<event_t> &event) {
+  char *oldstr = line;
+  char *newstr = NULL;
+  // number of events
+  idx_t jevent = strtoidx(oldstr, &newstr, 10);
+  oldstr = newstr;
+  event_t eventpre;
+  for (idx_t j = 0; j < jevent; ++j) {
+    // diffuse
+    eventpre.diffuse = strtotick(oldstr, &newstr, 16);
+    oldstr = newstr;
+    // type
+    idx_t type = strtoidx(oldstr, &newstr, 10);
+    oldstr = newstr;
+    eventpre.type = type;
+    // source
+    eventpre.source = strtoidx(oldstr, &newstr, 10);
+    oldstr = newstr;
+    // index
+    eventpre.index = strtoidx(oldstr, &newstr, 10);
+    oldstr = newstr;
+    // data
+    if (type == EVENT_SPIKE) {
+      eventpre.data = 0.0;
+    }
+    else {
+      eventpre.data = strtoreal(oldstr, &newstr);
+      oldstr = newstr;
+    }
+    event.push_back(eventpre);
+  }
+  return jevent;
+}
+
+// CSV row (comma delimited, empty elements skip a column)
+//   returns number of columns
+//
+idx_t GeNetCore::ParseCSVRow(char *line, std::unordered_map<idx_t, real_t> &row) {
+  char *oldstr = line;
+  char *newstr = NULL;
+  // read in columns (comma delimited)
+  idx_t i = 0;
+  for (;;) {
+    // check for empty element
+    // element
+    real_t element;
+    element = strtoreal(oldstr, &newstr);
+    oldstr = newstr;
+    // Add element to row
+    row.emplace(i, element);
+    // check for next element
+    // TODO: is this robust enough?
+    while (isspace(oldstr[0])) { ++oldstr; }
+    while (oldstr[0] == ',') { ++oldstr; ++i; }
+    // check for end of line (added by fgets)
+    if (oldstr[0] == '\0') { break; }
+  }
+  return i+1;
+}
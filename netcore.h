@@ -0,0 +1,296 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * netcore.h
+ * Network generation kernels (connections, sampling, parsing)
+ * independent of Charm++ so that they may be built and timed standalone
+ */
+
+#ifndef __STACS_NETCORE_H__
+#define __STACS_NETCORE_H__
+
+#include <cmath>
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "typedefs.h"
+#include "timing.h"
+
+
+#define GRAPHTYPE_NTYPE 3
+
+#define GRAPHTYPE_STR   0
+#define GRAPHTYPE_VTX   1
+#define GRAPHTYPE_EDG   2
+
+#define RNGTYPE_NRNG    11
+#define REPTYPE_REAL    0
+#define REPTYPE_TICK    1
+
+// TODO: reorder these numbers sometime
+#define RNGTYPE_CONST   0
+#define RNGTYPE_UNIF    1
+#define RNGTYPE_UNINT   2
+#define RNGTYPE_NORM    3
+#define RNGTYPE_BNORM   4
+#define RNGTYPE_LBNORM  5
+#define RNGTYPE_LIN     6
+#define RNGTYPE_LBLIN   7
+#define RNGTYPE_UBLIN   8
+#define RNGTYPE_BLIN    9
+#define RNGTYPE_FILE    10
+
+#define RNGPARAM_CONST  1
+#define RNGPARAM_UNIF   2
+#define RNGPARAM_UNINT  3
+#define RNGPARAM_NORM   2
+#define RNGPARAM_BNORM  3
+#define RNGPARAM_LBNORM 3
+#define RNGPARAM_LIN    2
+#define RNGPARAM_LBLIN  3
+#define RNGPARAM_UBLIN  3
+#define RNGPARAM_BLIN   4
+#define RNGPARAM_FILE   1
+
+#define VTXSHAPE_POINT  0
+#define VTXSHAPE_CIRCLE 1
+#define VTXSHAPE_SPHERE 2
+#define VTXSHAPE_RECT   3
+
+#define VTXPARAM_POINT  0
+#define VTXPARAM_CIRCLE 1
+#define VTXPARAM_SPHERE 1
+#define VTXPARAM_RECT   2
+
+#define CONNTYPE_UNIF   0
+#define PROBPARAM_UNIF  1
+#define MASKPARAM_UNIF  0
+
+#define CONNTYPE_SIG    1
+#define PROBPARAM_SIG   3
+#define MASKPARAM_SIG   0
+
+#define CONNTYPE_IDX    2
+#define PROBPARAM_IDX   0
+#define MASKPARAM_IDX   4
+
+#define CONNTYPE_FILE   3
+#define PROBPARAM_FILE  1
+#define MASKPARAM_FILE  2
+
+#define EVENT_SPIKE     0
+
+#define EVTGEN_NPARAM   3 // rate, tstart, tstop
+#define EVTGEN_POISSON  0
+#define EVTGEN_REGULAR  1
+
+
+/**************************************************************************
+* Data Structures
+**************************************************************************/
+
+// Model
+//
+struct model_t {
+  idx_t type;
+  std::string modname;
+  std::vector<idx_t> statetype;
+  std::vector<std::vector<real_t>> stateparam;
+  std::vector<idx_t> sticktype;
+  std::vector<std::vector<real_t>> stickparam;
+};
+
+// Vertices
+//
+struct vertex_t {
+  idx_t modidx;
+  idx_t order;
+  idx_t shape;
+  std::vector<real_t> param;
+  std::vector<real_t> coord;
+};
+
+// Edges
+//
+struct edge_t {
+  idx_t source;
+  std::vector<idx_t> target;
+  idx_t modidx;
+  real_t cutoff;
+  std::vector<idx_t> conntype;
+  std::vector<std::vector<real_t>> probparam;
+  std::vector<std::vector<idx_t>> maskparam;
+};
+
+// Event generators
+//
+struct evtgen_t {
+  idx_t type;
+  std::vector<idx_t> target; // vertex models that receive events
+  real_t rate;   // events per second
+  real_t tstart; // first possible event (ms)
+  real_t tstop;  // no events at or after (ms)
+};
+
+// Data files
+//
+struct datafile_t {
+  std::string filename;
+  // Sparse matrix (can also be used as a vector)
+  std::vector<std::unordered_map<idx_t, real_t>> matrix;
+};
+
+// Events
+//
+struct event_t {
+  tick_t diffuse;
+  idx_t type;
+  idx_t source;
+  idx_t index;
+  real_t data;
+
+  bool operator<(const event_t& event) const {
+    return diffuse < event.diffuse;
+  }
+};
+
+
+/**************************************************************************
+* Network Generation Kernels
+**************************************************************************/
+
+// Kernels shared by the chares and the micro-benchmarks
+//
+class GeNetCore {
+  public:
+    /* Constructors and Destructors */
+    GeNetCore();
+    virtual ~GeNetCore();
+
+    /* Errors (default exits, chares override) */
+    virtual void Abort();
+
+    /* Vertices */
+    std::vector<state_t> BuildVtxState(idx_t modidx, idx_t vtxidx);
+    std::vector<tick_t> BuildVtxStick(idx_t modidx, idx_t vtxidx);
+
+    /* Connections */
+    idx_t MakeConnection(idx_t source, idx_t target, idx_t sourceidx, idx_t targetidx, real_t dist);
+    std::vector<state_t> BuildEdgState(idx_t modidx, real_t dist, idx_t sourceidx, idx_t targetidx);
+    std::vector<tick_t> BuildEdgStick(idx_t modidx, real_t dist, idx_t sourceidx, idx_t targetidx);
+
+    /* Events */
+    idx_t BuildVtxEvent(idx_t modidx, idx_t vtxidx, std::mt19937 &evtngine, std::vector<event_t> &event);
+
+    /* Parsing */
+    idx_t strtomodidx(const char* nptr, char** endptr);
+    idx_t ParseAdjcy(char *line, std::vector<idx_t> &adj);
+    idx_t ParseState(char *line, std::vector<lidx_t> &edgmodidx,
+        std::vector<std::vector<state_t>> &state, std::vector<std::vector<tick_t>> &stick,
+        idx_t &nstate, idx_t &nstick);
+    idx_t ParseEvent(char *line, std::vector<event_t> &event);
+    idx_t ParseCSVRow(char *line, std::unordered_map<idx_t, real_t> &row);
+
+    /* Helper Functions */
+    // Compute sigmoid
+    real_t sigmoid(real_t x, real_t maxprob, real_t midpoint, real_t slope) {
+      return maxprob * (1.0 - 1.0/(1.0 + std::exp( -slope * (x - midpoint) )));
+    }
+    // Inverse of the cumulative distribution along a diameter
+    // of the unit circle/sphere (for placement in slabs)
+    real_t slabcircle(real_t u) {
+      // F(t) = 1/2 + (t sqrt(1-t^2) + asin(t))/pi
+      real_t lo = -1.0, hi = 1.0;
+      for (int k = 0; k < 48; ++k) {
+        real_t t = 0.5*(lo + hi);
+        if (0.5 + (t*std::sqrt(1.0 - t*t) + std::asin(t))/M_PI < u) { lo = t; }
+        else { hi = t; }
+      }
+      return 0.5*(lo + hi);
+    }
+    real_t slabsphere(real_t u) {
+      // F(t) = (2 + 3t - t^3)/4 (trigonometric root in [-1,1])
+      return 2.0*std::cos(std::acos(1.0 - 2.0*u)/3.0 - 2.0*M_PI/3.0);
+    }
+    // RNG State constant
+    real_t rngconst(real_t *param) {
+      return param[0];
+    }
+    // RNG State uniform
+    real_t rngunif(real_t *param) {
+      return param[0] + (param[1] - param[0])*((*unifdist)(rngine));
+    }
+    // RNG State uniform interval
+    real_t rngunint(real_t *param) {
+      return param[0] + param[2] * std::floor((((param[1] - param[0])/param[2])+1)*((*unifdist)(rngine)));
+    }
+    // RNG State normal
+    real_t rngnorm(real_t *param) {
+      return param[0] + (std::abs(param[1]))*((*normdist)(rngine));
+    }
+    // RNG State bounded normal
+    real_t rngbnorm(real_t *param) {
+      real_t state = (*normdist)(rngine);
+      real_t bound = std::abs(param[2]);
+      if (state > bound) { state = bound; }
+      else if (state < -bound) { state = -bound; }
+      return param[0] + (std::abs(param[1]))*state;
+    }
+    // RNG State lower bounded normal
+    real_t rnglbnorm(real_t *param) {
+      real_t state = (*normdist)(rngine);
+      state = param[0] + (std::abs(param[1]))*state;
+      if (state < param[2]) { state = param[2]; }
+      return state;
+    }
+    // RNG State linear
+    real_t rnglin(real_t *param, real_t dist) {
+      return dist*param[0] + param[1];
+    }
+    // RNG State lower bounded linear
+    real_t rnglblin(real_t *param, real_t dist) {
+      real_t state = dist*param[0] + param[1];
+      if (state < param[2]) {
+        state = param[3];
+      }
+      return state;
+    }
+    // RNG State bounded linear
+    real_t rngblin(real_t *param, real_t dist) {
+      real_t state = dist*param[0] + param[1];
+      if (state < param[2]) {
+        state = param[2];
+      }
+      if (state > param[3]) {
+        state = param[3];
+      }
+      return state;
+    }
+    // From datafile
+    // (currently conforms to numpy savetxt format for csv)
+    // Dimensions are stored: targetdim x sourcedim
+    real_t rngfile(real_t *param, idx_t sourceidx, idx_t targetidx);
+
+    /* Models */
+    std::vector<model_t> models;
+    std::unordered_map<std::string, idx_t> modmap; // maps model name to object index
+    std::vector<std::string> rngtype;     // rng types in order of definitions
+    std::vector<datafile_t> datafiles;
+    /* Graph information */
+    std::vector<edge_t> edges; // edge models and connection information
+    std::vector<evtgen_t> evtgens; // initial event generators
+    /* Random Number Generation */
+    std::mt19937 rngine;
+    std::uniform_real_distribution<real_t> *unifdist;
+    std::normal_distribution<real_t> *normdist;
+    /* Counters */
+    idx_t npairs; // vertex pairs evaluated for connection
+    idx_t nedges; // edges created
+};
+
+#endif //__STACS_NETCORE_H__
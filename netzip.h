@@ -0,0 +1,375 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * netzip.h
+ * Block-compressed streams for the state and event files
+ */
+
+#ifndef __STACS_NETZIP_H__
+#define __STACS_NETZIP_H__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+// Compressed files hold the same text as uncompressed ones, cut into
+// blocks of whole lines (about NETZIP_BLOCKSIZE bytes each) that are
+// deflated independently (zlib). A reader may decode blocks in any
+// order (or in parallel), and the index at the end of the file gives
+// the text offset, file offset and first line (vertex) of every block.
+//
+// Layout (native byte order):
+//   header  "GNZB" version blocksize                (u32 x3)
+//   blocks  rawsize zipsize data[zipsize]           (u32 x2, bytes)
+//   end     0 0                                     (u32 x2)
+//   index   rawoffset fileoffset firstline          (u64 x3, per block)
+//   trailer nblock "GNZI"                           (u64, u32)
+//
+// Streams are opened as FILE (through stdio cookies), so reading and
+// writing code is the same for text and compressed files. Reading
+// streams may also seek to a text offset (from the index).
+//
+// Each stream has one block in the background: when writing, a full
+// block is deflated by a helper thread while the next one is filled,
+// and when reading, the next block is read and inflated while the
+// current one is parsed. Only zlib is applied, the streams stay text
+// (so there are no fixed width columns for a shuffle or XOR stage).
+//
+#define NETZIP_MAGIC     0x425a4e47 // "GNZB"
+#define NETZIP_TRAILER   0x495a4e47 // "GNZI"
+#define NETZIP_VERSION   1
+#define NETZIP_BLOCKSIZE (1 << 20)
+
+#ifdef __APPLE__
+typedef off_t zipoff_t;
+#else
+typedef off64_t zipoff_t;
+#endif
+
+// Block index entry
+//
+struct zipblock_t {
+  uint64_t rawoffset;  // text offset
+  uint64_t fileoffset; // file offset (of the block header)
+  uint64_t firstline;  // lines before the block
+};
+
+// Compressed stream
+//
+struct zipfile_t {
+  FILE *pFile;
+  int level;             // compression level (writing)
+  std::vector<char> raw; // text of the current block
+  std::size_t rawpos;    // read position in the block
+  uint64_t rawoffset;    // text offset of the block
+  uint64_t nline;        // lines before the block
+  std::vector<unsigned char> zip;
+  std::vector<zipblock_t> index;
+  bool err;
+  std::vector<char> rawnext; // text of the block in the background
+  zipblock_t blocknext;
+  std::future<int> next;     // deflating (writing) or reading ahead
+};
+
+// Read the index of a compressed file
+//   returns 1 if the file is not compressed (or has no index)
+//
+inline int zipindex(FILE *pFile, std::vector<zipblock_t> &index) {
+  uint64_t nblock;
+  uint32_t magic;
+  if (fseeko(pFile, -((off_t) (sizeof(uint64_t) + sizeof(uint32_t))), SEEK_END) ||
+      fread(&nblock, sizeof(uint64_t), 1, pFile) != 1 ||
+      fread(&magic, sizeof(uint32_t), 1, pFile) != 1 || magic != NETZIP_TRAILER) {
+    return 1;
+  }
+  index.resize(nblock);
+  if (fseeko(pFile, -((off_t) (nblock*sizeof(zipblock_t) + sizeof(uint64_t) + sizeof(uint32_t))), SEEK_END) ||
+      fread(index.data(), sizeof(zipblock_t), nblock, pFile) != nblock) {
+    index.clear();
+    return 1;
+  }
+  return 0;
+}
+inline int zipindex(const char *filename, std::vector<zipblock_t> &index) {
+  FILE *pFile = fopen(filename, "rb");
+  if (pFile == NULL) {
+    return 1;
+  }
+  int err = zipindex(pFile, index);
+  fclose(pFile);
+  return err;
+}
+
+// Deflate the block in the background
+//
+inline int zipdeflate(zipfile_t *z) {
+  uLongf nzip = compressBound(z->rawnext.size());
+  z->zip.resize(nzip);
+  if (compress2(z->zip.data(), &nzip, (const Bytef *) z->rawnext.data(), z->rawnext.size(), z->level) != Z_OK) {
+    return 1;
+  }
+  z->zip.resize(nzip);
+  return 0;
+}
+
+// Write the block deflated in the background (if any)
+//
+inline int zipflush(zipfile_t *z) {
+  if (!z->next.valid()) {
+    return 0;
+  }
+  if (z->next.get()) {
+    return 1;
+  }
+  zipblock_t block = z->blocknext;
+  block.fileoffset = ftello(z->pFile);
+  uint32_t size[2] = {(uint32_t) z->rawnext.size(), (uint32_t) z->zip.size()};
+  if (fwrite(size, sizeof(uint32_t), 2, z->pFile) != 2 ||
+      fwrite(z->zip.data(), 1, z->zip.size(), z->pFile) != z->zip.size()) {
+    return 1;
+  }
+  z->index.push_back(block);
+  return 0;
+}
+
+// Compress and write a block (of the first n bytes)
+//   the previous block is written first, and this one
+//   is deflated in the background
+//
+inline int zipput(zipfile_t *z, std::size_t n) {
+  if (zipflush(z)) {
+    return 1;
+  }
+  z->blocknext.rawoffset = z->rawoffset;
+  z->blocknext.firstline = z->nline;
+  z->rawnext.assign(z->raw.begin(), z->raw.begin() + n);
+  z->nline += std::count(z->raw.begin(), z->raw.begin() + n, '\n');
+  z->rawoffset += n;
+  z->raw.erase(z->raw.begin(), z->raw.begin() + n);
+  z->next = std::async(std::launch::async, zipdeflate, z);
+  return 0;
+}
+
+// Read and inflate a block (in the background)
+//   leaves no text at the end of the blocks
+//
+inline int zipinflate(zipfile_t *z) {
+  uint32_t size[2];
+  z->rawnext.clear();
+  if (fread(size, sizeof(uint32_t), 2, z->pFile) != 2 || size[0] == 0) {
+    return 0;
+  }
+  z->zip.resize(size[1]);
+  z->rawnext.resize(size[0]);
+  uLongf nraw = size[0];
+  if (fread(z->zip.data(), 1, size[1], z->pFile) != size[1] ||
+      uncompress((Bytef *) z->rawnext.data(), &nraw, z->zip.data(), size[1]) != Z_OK || nraw != size[0]) {
+    z->rawnext.clear();
+    return 1;
+  }
+  return 0;
+}
+
+// Read and decompress the next block
+//   the block after it is read ahead in the background
+//   returns 1 at the end of the blocks
+//
+inline int zipget(zipfile_t *z) {
+  z->rawoffset += z->raw.size();
+  z->raw.clear();
+  z->rawpos = 0;
+  if (z->next.valid() ? z->next.get() : zipinflate(z)) {
+    z->err = true;
+    return 1;
+  }
+  z->raw.swap(z->rawnext);
+  if (z->raw.empty()) {
+    return 1;
+  }
+  z->next = std::async(std::launch::async, zipinflate, z);
+  return 0;
+}
+
+// Wait on the block in the background (discarding it)
+//
+inline void zipwait(zipfile_t *z) {
+  if (z->next.valid()) {
+    z->next.wait();
+    z->next = std::future<int>();
+  }
+}
+
+// Stream callbacks
+//
+inline ssize_t zipwrite(void *cookie, const char *buf, size_t size) {
+  zipfile_t *z = (zipfile_t *) cookie;
+  z->raw.insert(z->raw.end(), buf, buf + size);
+  // cut full blocks at the last line that fits (or the first that ends)
+  while (z->raw.size() >= NETZIP_BLOCKSIZE) {
+    std::vector<char>::iterator cut = z->raw.begin() + NETZIP_BLOCKSIZE;
+    std::vector<char>::reverse_iterator eol = std::find(std::vector<char>::reverse_iterator(cut), z->raw.rend(), '\n');
+    if (eol == z->raw.rend()) {
+      cut = std::find(cut, z->raw.end(), '\n');
+      if (cut == z->raw.end()) {
+        break;
+      }
+      ++cut;
+    }
+    else {
+      cut = eol.base();
+    }
+    if (zipput(z, cut - z->raw.begin())) {
+      z->err = true;
+      return 0;
+    }
+  }
+  return size;
+}
+inline ssize_t zipread(void *cookie, char *buf, size_t size) {
+  zipfile_t *z = (zipfile_t *) cookie;
+  if (z->rawpos == z->raw.size() && zipget(z)) {
+    return (z->err ? -1 : 0);
+  }
+  size_t n = std::min(size, z->raw.size() - z->rawpos);
+  memcpy(buf, z->raw.data() + z->rawpos, n);
+  z->rawpos += n;
+  return n;
+}
+inline int zipseek(void *cookie, zipoff_t *offset, int whence) {
+  zipfile_t *z = (zipfile_t *) cookie;
+  // position (text offset) only
+  if (whence == SEEK_CUR && *offset == 0) {
+    *offset = z->rawoffset + (z->level ? z->raw.size() : z->rawpos);
+    return 0;
+  }
+  // relative to the position (stdio may seek this way)
+  if (whence == SEEK_CUR && !z->level) {
+    *offset += z->rawoffset + z->rawpos;
+    whence = SEEK_SET;
+  }
+  if (whence != SEEK_SET || z->level || *offset < 0) {
+    return -1;
+  }
+  zipwait(z);
+  if (z->index.empty() && zipindex(z->pFile, z->index)) {
+    return -1;
+  }
+  // block holding the offset
+  std::size_t b = 0;
+  while (b+1 < z->index.size() && z->index[b+1].rawoffset <= (uint64_t) *offset) {
+    ++b;
+  }
+  if (z->index.empty() || fseeko(z->pFile, z->index[b].fileoffset, SEEK_SET)) {
+    return -1;
+  }
+  z->raw.clear();
+  z->rawoffset = z->index[b].rawoffset;
+  z->nline = z->index[b].firstline;
+  if (zipget(z) && z->err) {
+    return -1;
+  }
+  z->rawpos = std::min((std::size_t) (*offset - z->rawoffset), z->raw.size());
+  *offset = z->rawoffset + z->rawpos;
+  return 0;
+}
+inline int zipclose(void *cookie) {
+  zipfile_t *z = (zipfile_t *) cookie;
+  int err = z->err;
+  if (z->level) {
+    // last block, end and index
+    if (!err && z->raw.size()) {
+      err = zipput(z, z->raw.size());
+    }
+    if (zipflush(z)) {
+      err = 1;
+    }
+    uint32_t end[2] = {0, 0};
+    uint64_t nblock = z->index.size();
+    uint32_t magic = NETZIP_TRAILER;
+    if (!err && (fwrite(end, sizeof(uint32_t), 2, z->pFile) != 2 ||
+        fwrite(z->index.data(), sizeof(zipblock_t), nblock, z->pFile) != nblock ||
+        fwrite(&nblock, sizeof(uint64_t), 1, z->pFile) != 1 ||
+        fwrite(&magic, sizeof(uint32_t), 1, z->pFile) != 1)) {
+      err = 1;
+    }
+  }
+  zipwait(z);
+  if (fclose(z->pFile)) {
+    err = 1;
+  }
+  delete z;
+  return (err ? EOF : 0);
+}
+#ifdef __APPLE__
+inline int zipwritefn(void *cookie, const char *buf, int size) {
+  return zipwrite(cookie, buf, size);
+}
+inline int zipreadfn(void *cookie, char *buf, int size) {
+  return zipread(cookie, buf, size);
+}
+inline fpos_t zipseekfn(void *cookie, fpos_t offset, int whence) {
+  zipoff_t pos = offset;
+  return (zipseek(cookie, &pos, whence) ? -1 : pos);
+}
+#endif
+
+// Open a file (compressed when writing with a level above 0,
+// when reading the header tells)
+//
+inline FILE *zipopen(const char *filename, const char *mode, int level) {
+  bool writing = (mode[0] == 'w');
+  if (writing && level <= 0) {
+    return fopen(filename, mode);
+  }
+  FILE *pFile = fopen(filename, (writing ? "wb" : "rb"));
+  if (pFile == NULL) {
+    return NULL;
+  }
+  uint32_t header[3] = {NETZIP_MAGIC, NETZIP_VERSION, NETZIP_BLOCKSIZE};
+  if (writing) {
+    if (fwrite(header, sizeof(uint32_t), 3, pFile) != 3) {
+      fclose(pFile);
+      return NULL;
+    }
+  }
+  else if (fread(header, sizeof(uint32_t), 3, pFile) != 3 || header[0] != NETZIP_MAGIC) {
+    // plain text
+    rewind(pFile);
+    return pFile;
+  }
+  else if (header[1] != NETZIP_VERSION) {
+    fclose(pFile);
+    return NULL;
+  }
+  zipfile_t *z = new zipfile_t();
+  z->pFile = pFile;
+  z->level = (writing ? std::min(level, 9) : 0);
+  z->rawpos = 0;
+  z->rawoffset = 0;
+  z->nline = 0;
+  z->err = false;
+#ifdef __APPLE__
+  FILE *pZip = funopen(z, (writing ? NULL : zipreadfn), (writing ? zipwritefn : NULL), zipseekfn, zipclose);
+#else
+  cookie_io_functions_t zipfn;
+  zipfn.read = (writing ? NULL : zipread);
+  zipfn.write = (writing ? zipwrite : NULL);
+  zipfn.seek = zipseek;
+  zipfn.close = zipclose;
+  FILE *pZip = fopencookie(z, (writing ? "w" : "r"), zipfn);
+#endif
+  if (pZip == NULL) {
+    fclose(pFile);
+    delete z;
+  }
+  return pZip;
+}
+
+#endif //__STACS_NETZIP_H__
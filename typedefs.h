@@ -19,6 +19,26 @@ typedef uint64_t tick_t;
 typedef uint16_t flag_t;
 typedef real8 real_t;
 
+// Storage precision of vertex/edge state and coordinates
+// (parameters and intermediate computations stay real_t)
+#ifdef GENET_SINGLE
+typedef real4 state_t;
+typedef real4 coord_t;
+#else
+typedef real8 state_t;
+typedef real8 coord_t;
+#endif
+
+// Local indices (within a data file) and model indices
+// (global vertex indices are always idx_t)
+#ifdef GENET_LIDX32
+typedef int32_t lidx_t;
+#define LIDX_T_MAX      0x7FFFFFFF
+#else
+typedef int64_t lidx_t;
+#define LIDX_T_MAX      0x7FFFFFFFFFFFFFFF
+#endif
+
 // Reading from file
 #define strtoidx strtoll
 #define strtouidx strtoull
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2015 Felix Wang
+ *
+ * Simulation Tool for Asynchrnous Cortical Streams (stacs)
+ *
+ * varint.h
+ * Compact adjacency encoding (delta + varint)
+ */
+
+#ifndef __STACS_VARINT_H__
+#define __STACS_VARINT_H__
+
+#include <cstddef>
+#include "typedefs.h"
+
+// Adjacency lists are encoded one vertex at a time (a block) as
+// zigzag deltas from the previous entry, stored in little-endian
+// base-128 varints. Sorted lists with small gaps (as produced by
+// the cutoff-local connections) take one or two bytes per entry.
+// Unsorted lists still round trip, just less compactly. A prefix
+// of byte offsets per block (xadjcy) serves as the skip index.
+//
+// The encoding is used for adjacency in flight (messages, and the
+// connections packed for later files). Resident adjacency between
+// phases stays as plain indices: it is appended to while connecting,
+// searched and cut when splitting hubs and appending, merged and
+// remapped when ordering, and scanned by statistics and quality, so
+// an encoded copy would be decoded again by nearly every phase.
+//
+// Maximum size of an encoded entry (bytes)
+#define VARINT_MAXBYTES 10
+
+// Zigzag mapping of signed deltas to unsigned
+inline uidx_t zigzagenc(idx_t x) {
+  return (((uidx_t) x) << 1) ^ ((uidx_t) (x >> 63));
+}
+inline idx_t zigzagdec(uidx_t x) {
+  return (idx_t) (x >> 1) ^ -((idx_t) (x & 1));
+}
+
+// Number of bytes needed to encode a block
+//
+template <typename T>
+inline idx_t adjcysize(const T *adj, idx_t n) {
+  idx_t nbytes = 0;
+  idx_t prev = 0;
+  for (idx_t j = 0; j < n; ++j) {
+    uidx_t x = zigzagenc(adj[j] - prev);
+    prev = adj[j];
+    do {
+      ++nbytes;
+      x >>= 7;
+    } while (x);
+  }
+  return nbytes;
+}
+
+// Encode a block, returns number of bytes written
+//
+template <typename T>
+inline idx_t adjcyencode(const T *adj, idx_t n, uint8_t *buf) {
+  uint8_t *pos = buf;
+  idx_t prev = 0;
+  for (idx_t j = 0; j < n; ++j) {
+    uidx_t x = zigzagenc(adj[j] - prev);
+    prev = adj[j];
+    while (x >= 0x80) {
+      *pos++ = (uint8_t) (x | 0x80);
+      x >>= 7;
+    }
+    *pos++ = (uint8_t) x;
+  }
+  return (idx_t) (pos - buf);
+}
+
+// Decode a block of n entries, returns position after the block
+//
+template <typename T>
+inline const uint8_t* adjcydecode(const uint8_t *buf, idx_t n, T *adj) {
+  const uint8_t *pos = buf;
+  idx_t prev = 0;
+  for (idx_t j = 0; j < n; ++j) {
+    uidx_t x = 0;
+    int shift = 0;
+    // single byte entries are the common case
+    while (*pos & 0x80) {
+      x |= ((uidx_t) (*pos++ & 0x7F)) << shift;
+      shift += 7;
+    }
+    x |= ((uidx_t) (*pos++)) << shift;
+    prev += zigzagdec(x);
+    adj[j] = (T) prev;
+  }
+  return pos;
+}
+
+#endif //__STACS_VARINT_H__